@@ -0,0 +1,294 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+
+#include "syntheticdata.h"
+#include "database.h"
+#include "parseutil.h"
+#include "cardinfo.h"
+#include "cardstatistics.h"
+#include "effectsimplifier.h"
+#include "wordscanner.h"
+#include "textkernels.h"
+#include "quantile.h"
+#include "cardpooldiff.h"
+#include "lflistwriter.h"
+
+
+struct BenchmarkOptions {
+    SyntheticOptions synthetic;
+    QString dataDir;
+    int runs = 5;
+    bool helpNeeded = false;
+};
+
+// Timings of every run of one stage, over the same amount of items each run
+struct StageResult {
+    const char *name;
+    qsizetype items;
+    std::vector<double> milliseconds;
+};
+
+static BenchmarkOptions parseBenchmarkOptions(int argc, char *argv[]);
+static void printBenchmarkHelp();
+static ygo::CardStatistics calculateStatistics(const ygo::CardInfo &card);
+template <typename Function>
+static StageResult timeStage(const char *name, qsizetype items, int runs, Function run);
+static void printResults(const BenchmarkOptions &options, const SyntheticDataset &dataset,
+                         const std::vector<StageResult> &results);
+
+
+int main(int argc, char *argv[]) {
+    const BenchmarkOptions options = parseBenchmarkOptions(argc, argv);
+    if (options.helpNeeded) {
+        printBenchmarkHelp();
+        return 1;
+    }
+
+    // The dataset is generated in a temporary directory unless a directory to keep it in is given
+    QTemporaryDir temporaryDir;
+    const QString dataDir = options.dataDir.isEmpty() ? temporaryDir.path() : options.dataDir;
+    SyntheticDataset dataset;
+    if (!generateSyntheticDataset(dataDir, options.synthetic, &dataset)) {
+        return 1;
+    }
+
+    std::vector<StageResult> results;
+    const int runs = options.runs;
+
+    // Database reads
+    QMap<int, ygo::CardInfo> allCardsById;
+    results.push_back(timeStage("readCardInfoFromDatabase", dataset.cardCount, runs, [&] {
+        allCardsById = readCardInfoFromDatabase(dataset.includedDatabase).value_or(QMap<int, ygo::CardInfo>());
+    }));
+
+    QMultiMap<int, int> excludedIdsByAlias;
+    results.push_back(timeStage("readExcludedCardIds", dataset.excludedCount, runs, [&] {
+        excludedIdsByAlias = readExcludedCardIds(dataset.excludedDatabase).value_or(QMultiMap<int, int>());
+    }));
+
+    results.push_back(timeStage("readCardpoolFromAttachedDatabases", dataset.cardCount + dataset.excludedCount, runs, [&] {
+        QMap<int, ygo::CardInfo> cardsById;
+        QMultiMap<int, int> idsByAlias;
+        readCardpoolFromAttachedDatabases({ dataset.includedDatabase }, { dataset.excludedDatabase }, &cardsById, &idsByAlias);
+    }));
+
+    // Effect cards are filtered out of the cardpool the same way the generator does
+    QList<ygo::CardInfo> effectCards;
+    for (const auto &card : allCardsById) {
+        if (!(card.cardType() & ygo::Token || card.ot() == 8) && card.alias() == 0 && card.hasEffect()) {
+            effectCards.append(card);
+        }
+    }
+
+    // Effect text processing, first each step on its own, then all of them as CardStatistics does
+    QStringList simplifiedEffects;
+    results.push_back(timeStage("simplifyEffect", effectCards.count(), runs, [&] {
+        simplifiedEffects.clear();
+        for (const auto &card : effectCards) {
+            simplifiedEffects.append(ygo::simplifyEffect(card.description(), card.cardType()));
+        }
+    }));
+
+    results.push_back(timeStage("countWords", simplifiedEffects.count(), runs, [&] {
+        qsizetype words = 0;
+        for (const auto &effect : simplifiedEffects) {
+            words += ygo::countWords(effect);
+        }
+        return words;
+    }));
+
+    results.push_back(timeStage("countNonLineBreakChars", simplifiedEffects.count(), runs, [&] {
+        qsizetype chars = 0;
+        for (const auto &effect : simplifiedEffects) {
+            chars += ygo::countNonLineBreakChars(effect);
+        }
+        return chars;
+    }));
+
+    // The text kernels next to the regular expressions they replaced, on the same text. Whitespace is normalized on
+    // the full descriptions, as the simplified effects no longer have any runs of spaces.
+    results.push_back(timeStage("countNonLineBreakChars (regex)", simplifiedEffects.count(), runs, [&] {
+        static const QRegularExpression re_nonLineBreak(R"([^\r\n])");
+        qsizetype chars = 0;
+        for (const auto &effect : simplifiedEffects) {
+            chars += effect.count(re_nonLineBreak);
+        }
+        return chars;
+    }));
+
+    QStringList descriptions;
+    for (const auto &card : effectCards) {
+        descriptions.append(card.description());
+    }
+
+    results.push_back(timeStage("collapseSpacesAndTrim", descriptions.count(), runs, [&] {
+        qsizetype length = 0;
+        for (const auto &description : descriptions) {
+            length += ygo::collapseSpacesAndTrim(description).size();
+        }
+        return length;
+    }));
+
+    results.push_back(timeStage("collapseSpacesAndTrim (regex)", descriptions.count(), runs, [&] {
+        static const QRegularExpression re_repeatedWhitespace(R"( {2,})");
+        qsizetype length = 0;
+        for (const auto &description : descriptions) {
+            QString text = description;
+            length += text.replace(re_repeatedWhitespace, " ").trimmed().size();
+        }
+        return length;
+    }));
+
+    QList<ygo::CardStatistics> stats;
+    results.push_back(timeStage("CardStatistics", effectCards.count(), runs, [&] {
+        stats.clear();
+        for (const auto &card : effectCards) {
+            stats.append(ygo::CardStatistics(card));
+        }
+    }));
+
+    results.push_back(timeStage("CardStatistics (concurrent)", effectCards.count(), runs, [&] {
+        return QtConcurrent::blockingMapped(effectCards, calculateStatistics).count();
+    }));
+
+    // Percentile selection, from collecting the count distributions to the cards within the 25th percentile
+    results.push_back(timeStage("percentile", stats.count(), runs, [&] {
+        ygo::CountHistogram wordCounts;
+        ygo::CountHistogram charCounts;
+        for (const auto &card : stats) {
+            wordCounts.add(card.wordCount());
+            charCounts.add(card.charCount());
+        }
+
+        const double wordPercentile = wordCounts.percentile(25, ygo::QuantileMethod::Rounded);
+        const double charPercentile = charCounts.percentile(25, ygo::QuantileMethod::Rounded);
+        return std::count_if(stats.cbegin(), stats.cend(), [&](const ygo::CardStatistics &card) {
+            return card.wordCount() <= wordPercentile && card.charCount() <= charPercentile;
+        });
+    }));
+
+    LFList previousLFList;
+    results.push_back(timeStage("parseLFList", dataset.cardCount, runs, [&] {
+        previousLFList = parseLFList(dataset.previousLFList);
+    }));
+
+    // Output writing, of every card in the pool with its limit carried over from the previous lflist
+    QHash<int, int> limitsById;
+    for (const auto &card : allCardsById) {
+        limitsById.insert(card.id(), previousLFList.limitsById.value(card.id(), 3));
+    }
+    const QString outputLFList = QDir(dataDir).filePath("output.lflist.conf");
+    results.push_back(timeStage("LFListWriter", allCardsById.count(), runs, [&] {
+        QFile conf(outputLFList);
+        if (!conf.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        ygo::LFListWriter out(&conf);
+        out.writeHeader(QStringLiteral("Benchmark"));
+        for (const auto &card : allCardsById) {
+            out.writeCard(card.id(), limitsById.value(card.id()), card.nameUtf8());
+        }
+        return out.flush();
+    }));
+
+    const QList<int> excludedIds = excludedIdsByAlias.values();
+    results.push_back(timeStage("diffCardpool", limitsById.count(), runs, [&] {
+        return ygo::diffCardpool(limitsById, excludedIds, previousLFList.limitsById, previousLFList.excludedIds)
+            .addedIds.count();
+    }));
+
+    printResults(options, dataset, results);
+
+    return 0;
+}
+
+
+BenchmarkOptions parseBenchmarkOptions(int argc, char *argv[]) {
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = argv[i];
+        bool ok = i < argc - 1;
+        if (arg == "-n" && ok) {
+            options.synthetic.cardCount = QString(argv[++i]).toInt(&ok);
+            ok = ok && options.synthetic.cardCount > 0;
+        } else if (arg == "-r" && ok) {
+            options.runs = QString(argv[++i]).toInt(&ok);
+            ok = ok && options.runs > 0;
+        } else if (arg == "-s" && ok) {
+            options.synthetic.seed = QString(argv[++i]).toUInt(&ok);
+        } else if (arg == "-k" && ok) {
+            options.dataDir = argv[++i];
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            options.helpNeeded = true;
+            break;
+        }
+    }
+
+    return options;
+}
+
+void printBenchmarkHelp() {
+    std::cout << R"(
+OPTIONAL arguments:
+  -n <cards>    Specify the amount of cards in the synthetic card database
+                  (default 10000).
+  -r <runs>     Specify how many times each stage is run (default 5).
+  -s <seed>     Specify the seed of the synthetic dataset (default 1). The same
+                  seed and amount of cards always generate the same dataset.
+  -k <path>     Specify a directory to generate the dataset in and keep it
+                  afterwards, instead of a temporary directory.
+
+The results are printed as one tab-separated line per stage, with the fastest
+and median run time and the throughput of the median run.
+)" << std::endl;
+}
+
+ygo::CardStatistics calculateStatistics(const ygo::CardInfo &card) {
+    return ygo::CardStatistics(card);
+}
+
+template <typename Function>
+StageResult timeStage(const char *name, qsizetype items, int runs, Function run) {
+    StageResult result { name, items, {} };
+
+    for (int i = 0; i < runs; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto end = std::chrono::steady_clock::now();
+        result.milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(result.milliseconds.begin(), result.milliseconds.end());
+
+    return result;
+}
+
+void printResults(const BenchmarkOptions &options, const SyntheticDataset &dataset,
+                  const std::vector<StageResult> &results) {
+    std::cout << "# cards=" << dataset.cardCount << " excluded=" << dataset.excludedCount
+              << " seed=" << options.synthetic.seed << " runs=" << options.runs << '\n';
+    std::cout << "stage\titems\tmin_ms\tmedian_ms\titems_per_s\n";
+
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(3);
+    for (const auto &result : results) {
+        const double min = result.milliseconds.front();
+        const double median = result.milliseconds[result.milliseconds.size() / 2];
+        const double throughput = median > 0 ? result.items / (median / 1000.0) : 0;
+
+        std::cout << result.name << '\t' << result.items << '\t' << min << '\t' << median << '\t' << throughput << '\n';
+    }
+}
@@ -0,0 +1,312 @@
+#include "syntheticdata.h"
+#include "cardinfo.h"
+
+#include <sqlite3.h>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <QDir>
+#include <QFile>
+#include <QtMath>
+
+
+struct SyntheticCard {
+    int id;
+    int ot;
+    int alias;
+    quint32 type;
+    QString name;
+    QString description;
+};
+
+// The distributions of the standard library are implementation-defined, so values are drawn from the raw engine output
+// to keep datasets identical across platforms
+class SyntheticRandom {
+public:
+    explicit SyntheticRandom(quint32 seed) : m_engine(seed) {}
+
+    int between(int low, int high) { return low + static_cast<int>(m_engine() % static_cast<quint32>(high - low + 1)); }
+    double uniform() { return (m_engine() + 0.5) / 4294967296.0; }
+    bool chance(double probability) { return uniform() < probability; }
+
+    // Log-normally distributed value with the given median
+    double logNormal(double median, double sigma) {
+        const double radius = std::sqrt(-2.0 * std::log(uniform()));
+        const double normal = radius * std::cos(2.0 * M_PI * uniform());
+        return median * std::exp(sigma * normal);
+    }
+
+    template <typename T, size_t N>
+    const T &pick(const T (&values)[N]) { return values[m_engine() % N]; }
+
+private:
+    std::mt19937 m_engine;
+};
+
+static quint32 randomCardType(SyntheticRandom &random);
+static QString randomName(SyntheticRandom &random, int index);
+static QString randomDescription(SyntheticRandom &random, const QString &name, quint32 type);
+static QString randomSentence(SyntheticRandom &random, const QString &name);
+static QString randomText(SyntheticRandom &random, const QString &name, int words);
+static bool writeCardDatabase(const QString &path, const std::vector<SyntheticCard> &cards);
+static bool writeLFList(const QString &path, const QString &title, const std::vector<std::pair<int, int>> &limits,
+                        const std::vector<SyntheticCard> &cards);
+
+
+bool generateSyntheticDataset(const QString &dir, const SyntheticOptions &options, SyntheticDataset *dataset) {
+    SyntheticRandom random(options.seed);
+
+    // Alt arts follow their original card, with the next id and the same text. Tokens and pre-errata cards are kept in
+    // the database, just as in the real ones, so the filtering is measured as well.
+    std::vector<SyntheticCard> cards;
+    cards.reserve(static_cast<size_t>(options.cardCount));
+    int id = 10000000;
+    while (static_cast<int>(cards.size()) < options.cardCount) {
+        id += random.between(2, 40);
+
+        SyntheticCard card;
+        card.id = id;
+        card.ot = random.chance(0.005) ? 8 : random.pick({ 1, 2, 3, 3, 3 });
+        card.alias = 0;
+        card.type = randomCardType(random);
+        card.name = randomName(random, static_cast<int>(cards.size()));
+        card.description = randomDescription(random, card.name, card.type);
+        cards.push_back(card);
+
+        if (random.chance(0.04) && static_cast<int>(cards.size()) < options.cardCount) {
+            SyntheticCard altArt = cards.back();
+            altArt.id = id + 1;
+            altArt.alias = id;
+            cards.push_back(altArt);
+        }
+    }
+
+    // Rush and anime versions of about a tenth of the cards, with ids outside of the included range
+    std::vector<SyntheticCard> excludedCards;
+    for (const auto &card : cards) {
+        if (card.alias == 0 && random.chance(0.1)) {
+            SyntheticCard excluded = card;
+            excluded.id = 160000000 + static_cast<int>(excludedCards.size());
+            excluded.alias = card.id;
+            excludedCards.push_back(excluded);
+        }
+    }
+
+    // The previous lflist holds most of the legal cardpool, and the current format lflist a banlist worth of cards
+    std::vector<std::pair<int, int>> previousLimits;
+    std::vector<std::pair<int, int>> currentFormatLimits;
+    for (const auto &card : cards) {
+        if (random.chance(0.9)) {
+            previousLimits.emplace_back(card.id, random.chance(0.05) ? random.between(0, 2) : 3);
+        }
+        if (random.chance(0.03)) {
+            currentFormatLimits.emplace_back(card.id, random.between(0, 2));
+        }
+    }
+    for (const auto &card : excludedCards) {
+        if (random.chance(0.9)) {
+            previousLimits.emplace_back(card.id, -1);
+        }
+    }
+
+    QDir().mkpath(dir);
+    dataset->dbPath = dir;
+    dataset->includedDatabase = QDir(dir).filePath("cards.cdb");
+    dataset->excludedDatabase = QDir(dir).filePath("rush.cdb");
+    dataset->previousLFList = QDir(dir).filePath("previous.lflist.conf");
+    dataset->currentFormatLFList = QDir(dir).filePath("current.lflist.conf");
+    dataset->cardCount = static_cast<int>(cards.size());
+    dataset->excludedCount = static_cast<int>(excludedCards.size());
+
+    return writeCardDatabase(dataset->includedDatabase, cards)
+        && writeCardDatabase(dataset->excludedDatabase, excludedCards)
+        && writeLFList(dataset->previousLFList, "Previous", previousLimits, cards)
+        && writeLFList(dataset->currentFormatLFList, "Current", currentFormatLimits, cards);
+}
+
+// Roughly the proportions of the real card databases
+quint32 randomCardType(SyntheticRandom &random) {
+    const double roll = random.uniform();
+    if (roll < 0.30) {
+        return ygo::Monster | ygo::Effect;
+    } else if (roll < 0.36) {
+        return ygo::Monster | ygo::Normal;
+    } else if (roll < 0.38) {
+        return ygo::Monster | ygo::Effect | ygo::Ritual;
+    } else if (roll < 0.42) {
+        return ygo::Monster | ygo::Effect | ygo::Fusion;
+    } else if (roll < 0.46) {
+        return ygo::Monster | ygo::Effect | ygo::Synchro;
+    } else if (roll < 0.50) {
+        return ygo::Monster | ygo::Effect | ygo::Xyz;
+    } else if (roll < 0.53) {
+        return ygo::Monster | ygo::Effect | ygo::Link;
+    } else if (roll < 0.55) {
+        return ygo::Monster | ygo::Effect | ygo::Pendulum;
+    } else if (roll < 0.555) {
+        return ygo::Monster | ygo::Normal | ygo::Pendulum;
+    } else if (roll < 0.565) {
+        return ygo::Monster | ygo::Effect | ygo::Gemini;
+    } else if (roll < 0.575) {
+        return ygo::Monster | ygo::Normal | ygo::Token;
+    } else if (roll < 0.82) {
+        return ygo::Spell | random.pick({ ygo::NullType, ygo::NullType, ygo::QuickPlay, ygo::Continuous, ygo::Equip, ygo::Field });
+    } else {
+        return ygo::Trap | random.pick({ ygo::NullType, ygo::NullType, ygo::Continuous, ygo::Counter });
+    }
+}
+
+QString randomName(SyntheticRandom &random, int index) {
+    static const char *words[] = {
+        "Blue-Eyes", "Dragon", "Magician", "Knight", "Lord", "Shaddoll", "Sky Striker", "Ash", "Blossom", "Spring",
+        "Crystal", "Beast", "Warrior", "Destiny", "HERO", "Cyber", "Dark", "Light", "Abyss", "Flame", "Emperor",
+    };
+
+    // The index keeps every name unique, as alt arts are the only cards that share one
+    const QString first = random.pick(words);
+    const QString second = random.pick(words);
+    return QString("%1 %2 %3").arg(first, second).arg(index);
+}
+
+QString randomDescription(SyntheticRandom &random, const QString &name, quint32 type) {
+    const ygo::CardType cardType(type);
+
+    // Normal monsters have shorter flavor text, and effects are mostly between 20 and 150 words
+    if (cardType & ygo::Normal && !(cardType & ygo::Pendulum)) {
+        return randomText(random, name, std::min(80, static_cast<int>(random.logNormal(25, 0.4)))) + '.';
+    }
+
+    QString description;
+    if (cardType & ygo::Pendulum) {
+        description += "[ Pendulum Effect ]\r\n" + randomSentence(random, name) + "\r\n" + QString('-').repeated(40) + "\r\n";
+        description += cardType & ygo::Normal ? "[ Flavor Text ]\r\n" : "[ Monster Effect ]\r\n";
+    }
+    if (cardType & ygo::Extra) {
+        description += random.pick({ "2 Effect Monsters", "1 Tuner + 1+ non-Tuner monsters", "2 Level 4 monsters" });
+        description += "\r\n";
+    }
+    if (cardType & ygo::Gemini) {
+        description += "This card is treated as a Normal Monster while face-up on the field or in the GY. "
+                       "While this card is a Normal Monster on the field, you can Normal Summon it to have it become "
+                       "an Effect Monster with this effect.\r\n●";
+    }
+    if (random.chance(0.05)) {
+        description += QString("(This card is always treated as a \"%1\" card.)\r\n").arg(name.section(' ', 0, 0));
+    }
+
+    const int words = std::max(8, std::min(400, static_cast<int>(random.logNormal(55, 0.55))));
+    while (description.count(' ') < words) {
+        description += randomSentence(random, name) + ' ';
+    }
+
+    return description.trimmed();
+}
+
+QString randomSentence(SyntheticRandom &random, const QString &name) {
+    static const char *sentences[] = {
+        "If this card is Normal or Special Summoned: You can add 1 monster from your Deck to your hand.",
+        "You can target 1 card on the field; destroy it.",
+        "You can only use this effect of \"%1\" once per turn.",
+        "When your opponent activates a card or effect (Quick Effect): You can negate the activation.",
+        "Once per turn: You can banish 1 card from your GY; this card gains 500 ATK.",
+        "If this card is sent to the GY: You can Special Summon it (but its effects can still be activated).",
+        "Your opponent cannot activate cards or effects in response to this effect's activation (when this card resolves).",
+        "Add 1 card (Monster, Spell, or Trap) from your Deck to your hand.",
+        "Target 1 monster (Ritual, Fusion, Synchro, or Xyz) in your GY; Special Summon it.",
+        "Special Summon 1 \"%1 Token\" (Fairy/LIGHT/Level 1/ATK 0/DEF 0).",
+    };
+
+    const QString sentence = random.pick(sentences);
+    return sentence.contains("%1") ? sentence.arg(name) : sentence;
+}
+
+QString randomText(SyntheticRandom &random, const QString &name, int words) {
+    QString text = name;
+    while (text.count(' ') < words) {
+        text += ' ';
+        text += random.pick({ "the", "ancient", "dragon", "of", "legend", "whose", "power", "was", "sealed", "in", "a" });
+    }
+    return text;
+}
+
+bool writeCardDatabase(const QString &path, const std::vector<SyntheticCard> &cards) {
+    QFile::remove(path);
+
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(path.toUtf8().constData(), &db) != SQLITE_OK) {
+        std::cerr << "Synthetic database could not be created: " << sqlite3_errmsg(db) << '\n';
+        sqlite3_close(db);
+        return false;
+    }
+
+    // The same schema as the EDOPro card databases
+    const char *schema =
+        "pragma journal_mode = off; pragma synchronous = off; begin;"
+        "create table datas(id integer primary key,ot integer,alias integer,setcode integer,type integer,atk integer,"
+        "def integer,level integer,race integer,attribute integer,category integer);"
+        "create table texts(id integer primary key,name text,desc text,str1 text,str2 text,str3 text,str4 text,"
+        "str5 text,str6 text,str7 text,str8 text,str9 text,str10 text,str11 text,str12 text,str13 text,str14 text,"
+        "str15 text,str16 text);";
+
+    sqlite3_stmt *datas = nullptr;
+    sqlite3_stmt *texts = nullptr;
+    bool ok = sqlite3_exec(db, schema, nullptr, nullptr, nullptr) == SQLITE_OK
+        && sqlite3_prepare_v2(db, "insert into datas values(?1,?2,?3,0,?4,0,0,0,0,0,0)", -1, &datas, nullptr) == SQLITE_OK
+        && sqlite3_prepare_v2(db, "insert into texts(id,name,desc) values(?1,?2,?3)", -1, &texts, nullptr) == SQLITE_OK;
+
+    for (size_t i = 0; ok && i < cards.size(); ++i) {
+        const auto &card = cards[i];
+        const auto name = card.name.toUtf8();
+        const auto description = card.description.toUtf8();
+
+        sqlite3_bind_int(datas, 1, card.id);
+        sqlite3_bind_int(datas, 2, card.ot);
+        sqlite3_bind_int(datas, 3, card.alias);
+        sqlite3_bind_int64(datas, 4, card.type);
+        sqlite3_bind_int(texts, 1, card.id);
+        sqlite3_bind_text(texts, 2, name.constData(), name.size(), SQLITE_TRANSIENT);
+        sqlite3_bind_text(texts, 3, description.constData(), description.size(), SQLITE_TRANSIENT);
+
+        ok = sqlite3_step(datas) == SQLITE_DONE && sqlite3_step(texts) == SQLITE_DONE;
+        sqlite3_reset(datas);
+        sqlite3_reset(texts);
+    }
+
+    ok = ok && sqlite3_exec(db, "commit;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!ok) {
+        std::cerr << "Synthetic database could not be written: " << sqlite3_errmsg(db) << '\n';
+    }
+
+    sqlite3_finalize(datas);
+    sqlite3_finalize(texts);
+    sqlite3_close(db);
+
+    return ok;
+}
+
+bool writeLFList(const QString &path, const QString &title, const std::vector<std::pair<int, int>> &limits,
+                 const std::vector<SyntheticCard> &cards) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "Synthetic lflist could not be created: " << path.toStdString() << '\n';
+        return false;
+    }
+
+    QString text = QString("#[%1]\n!%1\n$whitelist\n\n").arg(title);
+    size_t card = 0;
+    for (const auto &limit : limits) {
+        if (limit.second < 0) {
+            text += QString("%1 -1\n").arg(limit.first);
+            continue;
+        }
+
+        // Limits are in id order, so the names are found by walking the cards alongside them
+        while (cards[card].id != limit.first) {
+            ++card;
+        }
+        text += QString("%1 %2 --%3\n").arg(limit.first, 8, 10, QChar('0')).arg(limit.second).arg(cards[card].name);
+    }
+
+    return file.write(text.toUtf8()) >= 0;
+}
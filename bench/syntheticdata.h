@@ -0,0 +1,28 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QString>
+#include <QtGlobal>
+
+
+struct SyntheticOptions {
+    int cardCount = 10000;      // Cards in the included database, alt arts included
+    quint32 seed = 1;
+};
+
+// The files of a generated dataset, laid out like an EDOPro database directory
+struct SyntheticDataset {
+    QString dbPath;
+    QString includedDatabase;       // cards.cdb
+    QString excludedDatabase;       // rush.cdb, alt versions of cards with an alias into cards.cdb
+    QString previousLFList;         // Most of the cardpool, with limits and excluded ids
+    QString currentFormatLFList;    // A banlist sized selection of limited cards
+    int cardCount = 0;
+    int excludedCount = 0;
+};
+
+// Generates a synthetic dataset in dir. The type mix and text lengths follow the real card databases, including the
+// boiler-plate that effect simplification removes. The same options always generate the same files, on any platform.
+bool generateSyntheticDataset(const QString &dir, const SyntheticOptions &options, SyntheticDataset *dataset);
+
+#endif // SYNTHETICDATA_H
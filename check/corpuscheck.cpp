@@ -0,0 +1,109 @@
+#include <iostream>
+#include <QMap>
+#include <QRegularExpression>
+#include <QString>
+
+#include "database.h"
+#include "cardinfo.h"
+#include "effectsimplifier.h"
+#include "wordscanner.h"
+#include "referencesimplifier.h"
+
+
+static void printCheckHelp();
+static bool checkWords(const QMap<int, ygo::CardInfo> &cardsById);
+static bool checkSimplify(const QMap<int, ygo::CardInfo> &cardsById);
+static int countWordsWithRegex(const QString &text);
+
+
+// Checks the text processing of the generator against the regular expressions it replaced, over every card of a
+// real database. Exits with 1 on the first card whose results differ.
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printCheckHelp();
+        return 1;
+    }
+
+    const QString check = argv[1];
+    const QMap<int, ygo::CardInfo> cardsById = readCardInfoFromDatabase(argv[2]).value_or(QMap<int, ygo::CardInfo>());
+    if (cardsById.isEmpty()) {
+        std::cout << "Could not read any cards from the database: " << argv[2] << '\n';
+        return 1;
+    }
+
+    bool ok = false;
+    if (check == "words") {
+        ok = checkWords(cardsById);
+    } else if (check == "simplify") {
+        ok = checkSimplify(cardsById);
+    } else {
+        printCheckHelp();
+        return 1;
+    }
+
+    if (ok) {
+        std::cout << "Checked " << cardsById.count() << " cards, no differences found\n";
+    }
+
+    return ok ? 0 : 1;
+}
+
+
+void printCheckHelp() {
+    std::cout << R"(
+Usage: ygopfg_check <check> <database.cdb>
+
+Checks:
+  words         Counts the words of every description, and of every simplified
+                  effect, with countWords() and with the regular expression
+                  it replaced.
+  simplify      Simplifies the effect of every card with simplifyEffect() and
+                  with the original regular expressions applied one after
+                  another, and compares the text.
+)" << std::endl;
+}
+
+bool checkWords(const QMap<int, ygo::CardInfo> &cardsById) {
+    for (const auto &card : cardsById) {
+        const QString description = card.description();
+        const QString simplifiedEffect = ygo::simplifyEffect(description, card.cardType());
+        for (const auto &text : { description, simplifiedEffect }) {
+            const int expected = countWordsWithRegex(text);
+            const int actual = ygo::countWords(text);
+            if (actual != expected) {
+                std::cout << "Word counts differ for card " << card.id() << ": countWords() found " << actual
+                          << ", the regular expression found " << expected << "\n\n" << text.toStdString() << '\n';
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool checkSimplify(const QMap<int, ygo::CardInfo> &cardsById) {
+    for (const auto &card : cardsById) {
+        const QString description = card.description();
+        const QString expected = referenceSimplifyEffect(description, card.cardType());
+        const QString actual = ygo::simplifyEffect(description, card.cardType());
+        if (actual != expected) {
+            std::cout << "Simplified effects differ for card " << card.id() << "\n\nsimplifyEffect():\n"
+                      << actual.toStdString() << "\n\nOriginal rules:\n" << expected.toStdString() << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int countWordsWithRegex(const QString &text) {
+    static const QRegularExpression re_word(R"(\b[\w']+\b(-[\w']+\b)*)");
+    int words = 0;
+    auto it = re_word.globalMatch(text);
+    while (it.hasNext()) {
+        it.next();
+        ++words;
+    }
+
+    return words;
+}
@@ -0,0 +1,78 @@
+#include "referencesimplifier.h"
+
+#include <QRegularExpression>
+
+
+QString referenceSimplifyEffect(const QString &description, ygo::CardType cardType) {
+    QString simplifiedEffect = description;
+
+    // Remove inclusion/exclusion text.
+    static const QRegularExpression re_inclusionExclusion(R"(\(This card('s name)? is (always|not) treated as (an? )?"[^"]+"( card)?\.\))");
+    simplifiedEffect.remove(re_inclusionExclusion);
+
+    // Remove extra deck materials.
+    if (cardType & ygo::Extra && cardType & ygo::Monster) {
+        static const QRegularExpression re_materials(R"(^[^\r\n]+(\r\n|\r|\n))");
+        simplifiedEffect.remove(re_materials);
+    }
+
+    // Remove ritual spell card text.
+    if (cardType & ygo::Ritual && cardType & ygo::Monster) {
+        static const QRegularExpression re_ritualSpell1(R"(You can Ritual Summon this card with (a(ny)? )?"[^"]+"( Ritual Spell( Card)?| card)?\.)");
+        simplifiedEffect.remove(re_ritualSpell1);
+        static const QRegularExpression re_ritualSpell2(R"(This (card|monster) can only be Ritual Summoned with the Ritual Spell Card, "[^"]+"\.)");
+        simplifiedEffect.remove(re_ritualSpell2);
+    }
+
+    // Remove gemini summoning condition text.
+    if (cardType & ygo::Gemini && cardType & ygo::Monster) {
+        static const QRegularExpression re_geminiCondition(R"(^[^●]+)");
+        simplifiedEffect.remove(re_geminiCondition);
+    }
+
+    // Remove statlines of tokens and trap monsters.
+    static const QRegularExpression re_statline(R"( \([^\)]+/[^\)]+/Level \d{1,2}/ATK \d+/DEF \d+\))");
+    simplifiedEffect.remove(re_statline);
+
+    // Remove type of card "(Monster, Spell, or Trap)".
+    static const QRegularExpression re_cardType(R"( \(Monster, Spell,( (and/)?or)? Trap\))");
+    simplifiedEffect.remove(re_cardType);
+
+    // Remove type of monster card "(Ritual, Fusion, Synchro, Xyz, Pendulum, and Link)".
+    static const QRegularExpression re_monsterCardType(R"( \((Ritual|Fusion|Synchro|Xyz|Pendulum|Link)(,?( and| or)? (Ritual|Fusion|Synchro|Xyz|Pendulum|Link))+\))");
+    simplifiedEffect.remove(re_monsterCardType);
+
+    // Remove "(but [its/their] effects can still be activated)".
+    static const QRegularExpression re_stillBeActivated(R"( \(but (its|their) effects can still be activated\))");
+    simplifiedEffect.remove(re_stillBeActivated);
+
+    // Remove "(when this card resolves)".
+    static const QRegularExpression re_whenCardResolves(R"( \(when this card resolves\))");
+    simplifiedEffect.remove(re_whenCardResolves);
+
+    // Remove "(but [you] can [Normal] Set)".
+    static const QRegularExpression re_butCanSet(R"( \(but( you)? can( Normal)? Set\))");
+    simplifiedEffect.remove(re_butCanSet);
+
+    // Remove boiler-plate from the effects of pendulums.
+    if (cardType & ygo::Pendulum) {
+        if (cardType & ygo::Normal) {
+            if (simplifiedEffect.contains("[ Pendulum Effect ]")) {
+                simplifiedEffect.remove("[ Pendulum Effect ]");
+                static const QRegularExpression re_flavorText(R"(-{40}.*$)", QRegularExpression::DotMatchesEverythingOption);
+                simplifiedEffect.remove(re_flavorText);
+            } else {
+                simplifiedEffect.clear();
+            }
+        } else {
+            simplifiedEffect.remove("[ Pendulum Effect ]");
+            simplifiedEffect.remove(QString('-').repeated(40));
+            simplifiedEffect.remove("[ Monster Effect ]");
+        }
+    }
+
+    // Normalize whitespace
+    static const QRegularExpression re_repeatedWhitespace(R"( {2,})");
+    simplifiedEffect.replace(re_repeatedWhitespace, " ");
+    return simplifiedEffect.trimmed();
+}
@@ -0,0 +1,13 @@
+#ifndef REFERENCESIMPLIFIER_H
+#define REFERENCESIMPLIFIER_H
+
+#include <QString>
+
+#include "cardinfo.h"
+
+
+// Simplifies an effect with the original regular expressions, applied one after another exactly as the generator did
+// before they were moved into a rule table. simplifyEffect() must return the same text for every card.
+QString referenceSimplifyEffect(const QString &description, ygo::CardType cardType);
+
+#endif // REFERENCESIMPLIFIER_H
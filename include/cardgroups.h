@@ -0,0 +1,81 @@
+#ifndef CARDGROUPS_H
+#define CARDGROUPS_H
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <QHash>
+#include <QMap>
+#include <QString>
+
+#include "cardtable.h"
+#include "parseutil.h"
+
+
+namespace ygo {
+
+    // Every version of a card under one dense group number: its alt arts, which share its name, and the excluded
+    // versions (rush cards, anime cards, etc.) whose alias is the card. The ids of each group are stored contiguously,
+    // so the limit of a card and the ids excluded along with it are found without any lookups by name. Names are looked
+    // up in the card table the index was built from, which must outlive it.
+    class CardGroupIndex {
+    public:
+        // A contiguous run of ids of a group
+        class IdRange {
+        public:
+            IdRange(const int *first, const int *last) : m_first(first), m_last(last) {}
+
+            const int *begin() const { return m_first; }
+            const int *end() const { return m_last; }
+            qsizetype count() const { return m_last - m_first; }
+            bool isEmpty() const { return m_first == m_last; }
+
+        private:
+            const int *m_first;
+            const int *m_last;
+        };
+
+        // Groups the cards by name. The base card of a group is its last version without an alias, which is the one
+        // written to lflists, and only excluded versions of the base card join the group.
+        void build(const CardTable &cards, const QMultiMap<int, int> &excludedIdsByAlias);
+
+        int groupCount() const { return static_cast<int>(m_baseIds.size()); }
+
+        // Returns the group of a legal or excluded id, or of a card name, or -1 if there is none
+        int groupOf(int id) const { return m_groupsById.value(id, -1); }
+        int groupOf(std::string_view name) const;
+        int groupOf(const QString &name) const;
+
+        // Returns the group of a row of the card table the index was built from
+        int groupOfRow(int row) const { return m_groupsByRow[row]; }
+
+        // Returns the id of the base card, or 0 if every version of the card is an alt art
+        int baseId(int group) const { return m_baseIds[group]; }
+
+        // Returns every legal version of the card, highest id first
+        IdRange ids(int group) const;
+
+        // Returns the excluded versions of the base card
+        IdRange excludedIds(int group) const;
+
+        // Returns the limit of a group, which is the limit of the first of its ids found in previousLFList, then in
+        // currentFormatLFList, or 3 when neither lists it
+        int resolveLimit(int group, const LFList &previousLFList, const LFList &currentFormatLFList) const;
+
+        // Returns the limit of every group, indexed by group
+        std::vector<int> resolveLimits(const LFList &previousLFList, const LFList &currentFormatLFList) const;
+
+    private:
+        QHash<int, int> m_groupsById;
+        std::unordered_map<std::string_view, int> m_groupsByName;
+        std::vector<int> m_groupsByRow;
+        std::vector<int> m_baseIds;
+        std::vector<int> m_idOffsets;          // The ids of group g are m_ids[m_idOffsets[g]..m_idOffsets[g + 1]]
+        std::vector<int> m_ids;
+        std::vector<int> m_excludedOffsets;    // Likewise for m_excludedIds
+        std::vector<int> m_excludedIds;
+    };
+
+} // namespace ygo
+
+#endif // CARDGROUPS_H
@@ -1,9 +1,13 @@
 #ifndef CARDINFO_H
 #define CARDINFO_H
 
+#include <memory>
+#include <string_view>
 #include <QFlag>
 #include <QString>
 
+#include "stringarena.h"
+
 
 namespace ygo {
 
@@ -47,9 +51,20 @@ namespace ygo {
     Q_DECLARE_OPERATORS_FOR_FLAGS(CardType)
 
 
+    // A card as read from a database. Its name and description are kept as UTF-8 in a string arena. A card without an
+    // arena creates its own as soon as it is given any text. Cards that share a writable arena must not be given text
+    // from several threads at once.
+    //
+    // A card created over a read-only arena, such as every card of a database load or of a CardTable, is copy-on-write:
+    // before it is given any text, its name and description are copied into an arena of its own, and the shared arena
+    // is never changed.
     class CardInfo {
     public:
-        explicit CardInfo();
+        explicit CardInfo(std::shared_ptr<StringArena> strings = std::shared_ptr<StringArena>());
+
+        // Creates a card whose name and description are already in strings, which it only reads
+        CardInfo(std::shared_ptr<const StringArena> strings, StringRef name, StringRef description);
+
         CardInfo(const CardInfo &other) = default;
         CardInfo(CardInfo &&other) = default;
         CardInfo &operator=(const CardInfo &other) = default;
@@ -67,21 +82,35 @@ namespace ygo {
         CardType cardType() const { return m_cardType; }
         void setCardType(CardType cardType);
 
-        QString name() const { return m_name; }
+        QString name() const;
+        std::string_view nameUtf8() const;
         void setName(const QString &name);
+        void setNameUtf8(std::string_view name);
 
-        QString description() const { return m_description; }
+        QString description() const;
+        std::string_view descriptionUtf8() const;
         void setDescription(const QString &description);
+        void setDescriptionUtf8(std::string_view description);
 
         bool hasEffect() const;
 
+        // The read-only arena the name and description are in, which others may share without copying the text. A
+        // card that may still append to its arena returns none, as that would invalidate views into it.
+        std::shared_ptr<const StringArena> sharedStrings() const;
+        StringRef nameRef() const { return m_name; }
+        StringRef descriptionRef() const { return m_description; }
+
     private:
-        QString m_name;
-        QString m_description;
+        StringArena &strings();
+
+        std::shared_ptr<const StringArena> m_strings;
+        StringRef m_name;
+        StringRef m_description;
         CardType m_cardType;
         int m_id;
         int m_ot;
         int m_alias;
+        bool m_stringsWritable;
     };
 
 } // namespace ygo
@@ -0,0 +1,45 @@
+#ifndef CARDPOOLDIFF_H
+#define CARDPOOLDIFF_H
+
+#include <QList>
+#include <QHash>
+#include <QString>
+
+#include "cardtable.h"
+
+
+namespace ygo {
+
+    struct LimitChange {
+        int id;
+        int previousLimit;
+        int limit;
+    };
+
+    // Differences between a generated cardpool and the previous lflist of the same format
+    struct CardpoolDiff {
+        QList<int> addedIds;                // Cards in the cardpool that were not in the previous lflist
+        QList<int> removedIds;              // Cards in the previous lflist that are not in the cardpool
+        QList<LimitChange> limitChanges;    // Cards in both whose limit changed
+        QList<int> newlyExcludedIds;        // Excluded ids that were not excluded by the previous lflist
+        QList<int> noLongerExcludedIds;     // Ids excluded by the previous lflist that no longer are
+
+        bool hasCardChanges() const { return !addedIds.isEmpty() || !removedIds.isEmpty(); }
+    };
+
+    // Compares a cardpool, given as its card limits and excluded ids, with the limits and excluded ids of a previous
+    // lflist in linear time
+    CardpoolDiff diffCardpool(const QHash<int, int> &limitsById,
+                              const QList<int> &excludedIds,
+                              const QHash<int, int> &previousLimitsById,
+                              const QList<int> &previousExcludedIds);
+
+    // Writes a diff as a JSON report to path, naming every card that is found in cards
+    bool writeCardpoolDiffReport(const QString &path,
+                                 const QString &formatName,
+                                 const CardpoolDiff &diff,
+                                 const CardTable &cards);
+
+} // namespace ygo
+
+#endif // CARDPOOLDIFF_H
@@ -0,0 +1,37 @@
+#ifndef CARDSNAPSHOT_H
+#define CARDSNAPSHOT_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include "cardinfo.h"
+
+
+namespace ygo {
+
+    // A card database a snapshot was made from, identified by its size and modification time
+    struct SnapshotSource {
+        QString path;
+        qint64 size = 0;
+        qint64 lastModified = 0;    // Milliseconds since the epoch
+    };
+
+    // Returns every card database in dbPath, in the order they are read
+    QList<SnapshotSource> snapshotSources(const QString &dbPath);
+
+    // Loads the merged card table and excluded ids from the snapshot at path. The snapshot is memory-mapped and read
+    // column by column without any parsing, and the text of every card is copied into one string arena at once.
+    // Returns false, leaving both maps empty, when the snapshot is missing, corrupt, of another format version, or was
+    // made from databases other than sources.
+    bool loadCardSnapshot(const QString &path, const QList<SnapshotSource> &sources,
+                          QMap<int, CardInfo> *cardsById, QMultiMap<int, int> *excludedIdsByAlias);
+
+    // Saves the merged card table and excluded ids read from sources as a snapshot at path. The card ids, ots, aliases
+    // and types are stored as fixed width columns, and names and descriptions as offsets into a single UTF-8 blob.
+    bool saveCardSnapshot(const QString &path, const QList<SnapshotSource> &sources,
+                          const QMap<int, CardInfo> &cardsById, const QMultiMap<int, int> &excludedIdsByAlias);
+
+} // namespace ygo
+
+#endif // CARDSNAPSHOT_H
@@ -1,31 +1,56 @@
 #ifndef CARDSTATISTICS_H
 #define CARDSTATISTICS_H
 
+#include <QMutex>
+#include <QString>
+#include <QStringView>
+
 #include "cardinfo.h"
 
 
 namespace ygo {
 
+    // The simplified effects of many cards in a single buffer, which any thread may append to. Effects are referred to
+    // by offset and length, which stay valid as the arena grows.
+    class SimplifiedEffectArena {
+    public:
+        qsizetype append(QStringView text);
+        QString text(qsizetype offset, int length) const;
+
+    private:
+        mutable QMutex m_mutex;
+        QString m_text;
+    };
+
+    // The word and character counts of a card's simplified effect. Only the card id and counts are kept, unless the
+    // simplified effect is requested by giving an arena to keep it in.
     class CardStatistics {
     public:
-        explicit CardStatistics(const CardInfo &card);
+        // Must be incremented whenever a change to the simplification rules changes the statistics of any card
+        static constexpr int RulesVersion = 2;
+
+        // A record of no card, with no counts. QtConcurrent needs it to buffer mapped results.
+        CardStatistics();
+        explicit CardStatistics(const CardInfo &card, SimplifiedEffectArena *effects = nullptr);
+        CardStatistics(int cardId, int wordCount, int charCount);
         CardStatistics(const CardStatistics &other) = default;
         CardStatistics(CardStatistics &&other) = default;
         CardStatistics &operator=(const CardStatistics &other) = default;
         CardStatistics &operator=(CardStatistics &&other) = default;
 
-        QString name() const { return m_name; }
-        QString description() const { return m_description; }
-        QString simplifiedEffect() const { return m_simplifiedEffect; }
-        CardType cardType() const { return m_cardType; }
+        int cardId() const { return m_cardId; }
         int wordCount() const { return m_wordCount; }
         int charCount() const { return m_charCount; }
 
+        // The simplified effect, if it was kept in an arena
+        bool hasSimplifiedEffect() const { return m_effectOffset >= 0; }
+        QString simplifiedEffect(const SimplifiedEffectArena &effects) const;
+        void setSimplifiedEffect(SimplifiedEffectArena *effects, QStringView simplifiedEffect);
+
     private:
-        QString m_name;
-        QString m_description;
-        QString m_simplifiedEffect;
-        CardType m_cardType;
+        qsizetype m_effectOffset;
+        int m_effectLength;
+        int m_cardId;
         int m_wordCount;
         int m_charCount;
     };
@@ -0,0 +1,73 @@
+#ifndef CARDTABLE_H
+#define CARDTABLE_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <QMap>
+
+#include "cardinfo.h"
+#include "stringarena.h"
+
+
+namespace ygo {
+
+    // The legal cardpool, stored column by column with one row per card in id order. Cards are referred to by row once
+    // the table is built, so nothing is copied to select or sort them. The base cards (those without an alias) are
+    // also indexed by name, separately for cards with and without an effect. Names and descriptions stay in the
+    // read-only arenas of the cards the table is built from, which the table and its copies share. Only the text of
+    // cards that may still append to their arena is copied, into an arena of the table's own.
+    class CardTable {
+    public:
+        // Builds the table from the merged cards of every database, leaving out tokens and pre-errata cards
+        void build(const QMap<int, CardInfo> &allCardsById);
+
+        int count() const { return static_cast<int>(m_ids.size()); }
+
+        // Returns the row of a card id, or -1 if the card is not in the table
+        int rowOf(int id) const;
+
+        int id(int row) const { return m_ids[row]; }
+        int ot(int row) const { return m_ots[row]; }
+        int alias(int row) const { return m_aliases[row]; }
+        CardType cardType(int row) const { return m_cardTypes[row]; }
+        std::string_view name(int row) const { return m_arenas[m_arenaIndexes[row]]->view(m_names[row]); }
+        std::string_view description(int row) const { return m_arenas[m_arenaIndexes[row]]->view(m_descriptions[row]); }
+        bool hasEffect(int row) const { return m_hasEffect[row]; }
+
+        // The statistics of effect cards, which are 0 until they are set
+        int wordCount(int row) const { return m_wordCounts[row]; }
+        int charCount(int row) const { return m_charCounts[row]; }
+        void setCounts(int row, int wordCount, int charCount);
+
+        // Returns the card of a row, sharing its name and description with the table. Giving the card new text copies
+        // its text out of the table first, so the table and the views it hands out never change.
+        CardInfo card(int row) const;
+
+        // Returns the rows of the base cards with and without an effect, sorted by name
+        const std::vector<int> &effectRows() const { return m_effectRows; }
+        const std::vector<int> &nonEffectRows() const { return m_nonEffectRows; }
+
+        // Sorts rows by name, in UTF-8 byte order. Of the rows that share a name only the last one is kept, just as in
+        // a map by name.
+        std::vector<int> sortedByName(std::vector<int> rows) const;
+
+    private:
+        std::vector<int> m_ids;
+        std::vector<int> m_ots;
+        std::vector<int> m_aliases;
+        std::vector<CardType> m_cardTypes;
+        std::vector<std::shared_ptr<const StringArena>> m_arenas;
+        std::vector<int> m_arenaIndexes;
+        std::vector<StringRef> m_names;
+        std::vector<StringRef> m_descriptions;
+        std::vector<quint8> m_hasEffect;
+        std::vector<int> m_wordCounts;
+        std::vector<int> m_charCounts;
+        std::vector<int> m_effectRows;
+        std::vector<int> m_nonEffectRows;
+    };
+
+} // namespace ygo
+
+#endif // CARDTABLE_H
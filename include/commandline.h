@@ -4,13 +4,34 @@
 #include <QString>
 #include <QList>
 
+#include "quantile.h"
+
+
+// Options for a single lflist to be generated from the shared cardpool
+struct FormatOptions {
+    QString outputLFList;
+    QString prevLFList;
+    QString currentFormatLFList;
+    double percentile = -1;
+    ygo::QuantileMethod quantileMethod = ygo::QuantileMethod::Rounded;
+};
 
 struct CommandFlags {
     QString dbPath;
     QString outputLFList;
     QString prevLFList;
     QString currentFormatLFList;
-    double percentile;
+    QString batchFile;
+    QString statisticsCache;
+    QString snapshot;
+    QString exportEffects;      // File to write the simplified effects to, empty when not exporting
+    QString profileFormat;      // "table" or "json", empty when profiling is off
+    QString serveName;          // Local socket to answer queries on, empty when not serving
+    double percentile = -1;
+    ygo::QuantileMethod quantileMethod = ygo::QuantileMethod::Rounded;
+    QList<FormatOptions> formats;
+    bool attachDatabases = false;
+    bool watch = false;
     bool helpNeeded = false;
 };
 
@@ -1,3 +1,4 @@
+#include <optional>
 #include <QString>
 #include <QList>
 #include <QMap>
@@ -8,5 +9,14 @@
 
 QStringList getIncludedDatabaseFiles(const QFileInfoList &dbFiles);
 QStringList getExcludedDatabaseFiles(const QFileInfoList &dbFiles);
-QMap<int, ygo::CardInfo> readCardInfoFromDatabase(const QString &file);
-QMultiMap<int, int> readExcludedCardIds(const QString &file);
+
+// Read every card, or the excluded card ids by alias, of a single database. Nothing is returned when the database
+// could not be opened or not every row could be read.
+std::optional<QMap<int, ygo::CardInfo>> readCardInfoFromDatabase(const QString &file);
+std::optional<QMultiMap<int, int>> readExcludedCardIds(const QString &file);
+
+// Reads the legal cardpool from the included databases and the excluded card ids by alias from the excluded databases
+// through a single connection that attaches all of them. Tokens and pre-errata cards are filtered out by the query,
+// and descriptions are only read for cards that are not alt arts.
+bool readCardpoolFromAttachedDatabases(const QStringList &includedFiles, const QStringList &excludedFiles,
+                                       QMap<int, ygo::CardInfo> *cardsById, QMultiMap<int, int> *excludedIdsByAlias);
@@ -0,0 +1,58 @@
+#ifndef DATABASEWATCHER_H
+#define DATABASEWATCHER_H
+
+#include <functional>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QTimer>
+
+#include "pipeline.h"
+#include "statisticscache.h"
+
+
+namespace ygo {
+
+    // Keeps the cardpool of a database directory loaded, and builds it again whenever a database changes. Only the
+    // databases that changed are read again, and only cards whose text changed have their statistics calculated
+    // again. Changes are reported through the Qt event loop, which must be running.
+    class DatabaseWatcher {
+    public:
+        using UpdateFunction = std::function<void(const Cardpool &pool)>;
+
+        // The statistics cache is loaded from and saved to statisticsCachePath, if given
+        explicit DatabaseWatcher(const QString &dbPath, const QString &statisticsCachePath = QString());
+
+        DatabaseWatcher(const DatabaseWatcher &other) = delete;
+        DatabaseWatcher &operator=(const DatabaseWatcher &other) = delete;
+
+        // Also reports an update whenever one of these files changes, such as the lflists formats are generated from
+        void watchFiles(const QStringList &files);
+
+        // Loads the cardpool and reports it right away, then again after every change
+        void start(UpdateFunction onUpdate);
+
+        const Cardpool &cardpool() const { return m_pool; }
+
+    private:
+        void update();
+        bool databaseFilesChanged() const;
+        void watchPaths();
+
+        QString m_dbPath;
+        QString m_statisticsCachePath;
+        DatabaseContents m_contents;
+        StatisticsCache m_cache;
+        Cardpool m_pool;
+        UpdateFunction m_onUpdate;
+
+        QFileSystemWatcher m_watcher;
+        QTimer m_debounce;
+        QStringList m_extraFiles;
+        QStringList m_changedDatabases;
+        bool m_directoryChanged;
+        bool m_databasesChanged;
+    };
+
+} // namespace ygo
+
+#endif // DATABASEWATCHER_H
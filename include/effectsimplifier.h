@@ -0,0 +1,15 @@
+#ifndef EFFECTSIMPLIFIER_H
+#define EFFECTSIMPLIFIER_H
+
+#include "cardinfo.h"
+
+
+namespace ygo {
+
+    // Returns the effect text of a card with all of the boiler-plate that does not count towards its length removed
+    // (materials, summoning conditions, reminder text, pendulum headers, etc.) and its whitespace normalized
+    QString simplifyEffect(const QString &description, CardType cardType);
+
+} // namespace ygo
+
+#endif // EFFECTSIMPLIFIER_H
@@ -0,0 +1,58 @@
+#ifndef LFLISTWRITER_H
+#define LFLISTWRITER_H
+
+#include <string_view>
+#include <vector>
+#include <QIODevice>
+#include <QStringView>
+
+
+namespace ygo {
+
+    // Writes lflist.conf files. Every line is formatted directly into a reusable UTF-8 buffer, which is only written to
+    // the device once it fills up, so writing a line never allocates.
+    class LFListWriter {
+    public:
+        explicit LFListWriter(QIODevice *device, int bufferSize = 64 * 1024);
+        ~LFListWriter();
+
+        LFListWriter(const LFListWriter &other) = delete;
+        LFListWriter &operator=(const LFListWriter &other) = delete;
+
+        // Writes the format's title, name and the $whitelist marker
+        void writeHeader(QStringView formatName);
+
+        // Writes a card entry with its id padded to 8 digits (Ex: 67284107 1 --Scapeghost)
+        void writeCard(int id, int limit, QStringView name);
+
+        // Writes a card entry whose name is already UTF-8, which is copied as it is
+        void writeCard(int id, int limit, std::string_view name);
+
+        // Writes an excluded card entry (Ex: 160001000 -1)
+        void writeExcludedId(int id);
+
+        // Writes text as it is, which is expected to be ASCII
+        void writeText(const char *text);
+
+        // Writes the buffer to the device, returning false if any write so far has failed
+        bool flush();
+
+        qint64 bytesWritten() const { return m_bytesWritten; }
+
+    private:
+        void reserve(size_t size);
+        void appendChar(char c) { m_buffer[m_used++] = c; }
+        void appendNumber(int number, int width = 0);
+        void appendCardPrefix(int id, int limit);
+        void appendUtf8(QStringView text);
+
+        QIODevice *m_device;
+        std::vector<char> m_buffer;
+        size_t m_used;
+        qint64 m_bytesWritten;
+        bool m_error;
+    };
+
+} // namespace ygo
+
+#endif // LFLISTWRITER_H
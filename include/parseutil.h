@@ -2,13 +2,22 @@
 #define PARSEUTIL_H
 
 #include <QString>
-#include <QMap>
+#include <QHash>
+#include <QList>
 
 
+// The card entries of an lflist.conf file
+struct LFList {
+    QHash<int, int> limitsById;     // Ex: 67284107 1 --Scapeghost
+    QList<int> excludedIds;         // Ex: 160001000 -1
+};
+
 // Returns the text contents of the file at path
 QString readTextFile(const QString &path);
 
-// Parses the lflist.conf file at the given path and returns the card limitations mapped by card id
-QMap<int, int> parseLFListConf(const QString &path);
+// Parses the lflist.conf file at the given path in a single pass over the memory-mapped file, returning both the card
+// limitations and the excluded card ids. Comments, shebangs, $whitelist and any other lines that are not card entries
+// are skipped. An empty path returns an empty lflist.
+LFList parseLFList(const QString &path);
 
 #endif // PARSEUTIL_H
@@ -0,0 +1,112 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <vector>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "cardgroups.h"
+#include "cardinfo.h"
+#include "cardpooldiff.h"
+#include "cardtable.h"
+#include "parseutil.h"
+#include "quantile.h"
+#include "statisticscache.h"
+
+
+namespace ygo {
+
+    // The cards read from each database file. Kept between loads, only the files that changed need to be read again.
+    struct DatabaseContents {
+        QStringList includedFiles;
+        QStringList excludedFiles;
+        QHash<QString, QMap<int, CardInfo>> cardsByFile;
+        QHash<QString, QMultiMap<int, int>> excludedIdsByFile;
+    };
+
+    // The legal cardpool along with the statistics of its effect cards, from which any amount of formats can be
+    // selected
+    struct Cardpool {
+        CardTable cards;                        // Every legal card, with the statistics of the effect cards
+        CardGroupIndex groups;                  // Every version of each card, with its excluded versions
+        CountHistogram wordCounts;
+        CountHistogram charCounts;
+        std::vector<CardStatistics> effectStatistics;   // Of every card in cards.effectRows(), only when the cache
+                                                        // keeps simplified effects
+    };
+
+    // The cards within a percentile of a cardpool, with the limit of every card
+    struct Format {
+        QString name;
+        double wordPercentile = 0;
+        double charPercentile = 0;
+        int effectCardCount = 0;                // Effect cards within the percentile
+        std::vector<int> rows;                  // Every card within the percentile, in the order they are written
+        QHash<int, int> limitsById;
+        std::vector<int> limitsByGroup;         // The limit of every card group of the cardpool
+        QList<int> excludedIds;                 // Excluded versions of the cards (rush cards, anime cards, etc.)
+        LFList previousLFList;
+        LFList currentFormatLFList;
+    };
+
+    // Reads every card database in dbPath and builds the cardpool, either concurrently or through a single connection
+    // that attaches every database. Statistics are looked up in and added to cache. When snapshotPath is given, the
+    // cards are loaded from the snapshot there if it is up to date, and it is written again otherwise. Returns false
+    // when a database could not be read, leaving pool empty rather than built from part of the cards.
+    bool loadCardpool(const QString &dbPath, bool attachDatabases, const QString &snapshotPath, StatisticsCache *cache,
+                      Cardpool *pool);
+
+    // Updates the database files from the ones now in dbPath, dropping the contents of files that no longer exist, and
+    // returns the files that are new
+    QStringList updateDatabaseFiles(const QString &dbPath, DatabaseContents *contents);
+
+    // Reads the given database files concurrently, replacing their previous contents. Returns the files that could not
+    // be read, which keep their previous contents.
+    QStringList readDatabases(const QStringList &files, DatabaseContents *contents);
+
+    // Merges the contents of every database in file order, so cards in later databases take precedence
+    void mergeDatabases(const DatabaseContents &contents, QMap<int, CardInfo> *cardsById,
+                        QMultiMap<int, int> *excludedIdsByAlias);
+
+    // Builds the cardpool from already loaded cards, removing tokens and pre-errata cards. Only effect cards without
+    // an up to date entry in cache have their statistics calculated.
+    Cardpool buildCardpool(const QMap<int, CardInfo> &allCardsById, const QMultiMap<int, int> &excludedIdsByAlias,
+                           StatisticsCache *cache);
+
+    // Selects the cards within the given percentile of both word and character counts. Limits are carried over from
+    // the previous lflist, then from the current format lflist, and default to 3. The lflists are kept in the format,
+    // so callers that no longer need them should move them in.
+    Format selectFormat(const Cardpool &pool, double percentile, QuantileMethod method,
+                        LFList previousLFList, LFList currentFormatLFList);
+
+    // Same as above, with the limits of every group of the cardpool already resolved from the lflists, as by
+    // CardGroupIndex::resolveLimits(). Callers that select many formats from the same lflists resolve them once.
+    Format selectFormat(const Cardpool &pool, double percentile, QuantileMethod method,
+                        LFList previousLFList, LFList currentFormatLFList, std::vector<int> limitsByGroup);
+
+    // Returns the limit of a card by name, looked up across every version of the card. Resolving the limits of every
+    // group at once with CardGroupIndex::resolveLimits() is preferred when many cards are looked up.
+    int cardLimit(const Cardpool &pool, const QString &name, const LFList &previousLFList,
+                  const LFList &currentFormatLFList);
+
+    // Compares a format with its previous lflist
+    CardpoolDiff diffFormat(const Format &format);
+
+    // Writes a format as an lflist.conf file. When a diff is given, the cards it adds and removes are listed as
+    // comments at the end.
+    bool writeFormat(QIODevice *device, const Format &format, const Cardpool &pool, const CardpoolDiff *diff = nullptr);
+
+    // Writes the simplified effect of every effect card, along with its counts, as a JSON array to path. The cardpool
+    // must have been built with a cache that keeps simplified effects in effects.
+    bool writeSimplifiedEffects(const QString &path, const Cardpool &pool, const SimplifiedEffectArena &effects);
+
+    // Returns the name of the format at a percentile for the current month (Ex: 2024.6 25th)
+    QString formatName(double percentile);
+
+} // namespace ygo
+
+#endif // PIPELINE_H
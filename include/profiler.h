@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <QByteArray>
+#include <QtGlobal>
+
+
+namespace ygo {
+
+    // The phases of a run, in the order they happen
+    enum class ProfileStage {
+        DatabaseLoad,
+        ExclusionMerge,
+        SnapshotWrite,
+        Filtering,
+        Statistics,
+        LFListParse,
+        Percentile,
+        Output,
+        Diff,
+        Count
+    };
+
+    enum class ProfileCounter {
+        RowsRead,           // Rows stepped through in the card databases
+        CardsFiltered,      // Tokens and pre-errata cards removed from the cardpool
+        RegexPasses,        // Scans of effect text by a regular expression
+        BytesWritten,       // Bytes written to lflists and diff reports
+        Count
+    };
+
+    // Process-wide stage timers and counters. Until enable() is called, timers never read the clock and counting is
+    // a single relaxed load, so the instrumentation can stay in place for every run.
+    namespace profiler {
+
+        extern std::atomic<bool> enabledFlag;
+
+        void enable();
+        inline bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+
+        void addTime(ProfileStage stage, std::chrono::steady_clock::duration time);
+        void addCount(ProfileCounter counter, qint64 amount);
+
+        // Called by the allocation hooks that builds with YGOPFG_ALLOC_TRACKING link into the executable, which tag
+        // every heap allocation to the stage that is being timed. The report only has allocation columns once they
+        // have been called, so programs without the hooks never report zeros. Neither may allocate.
+        void recordAllocation(std::size_t size);
+        void recordDeallocation(std::size_t size);
+
+        // Counters are best kept in a local variable within loops and added once, as threads share them
+        inline void count(ProfileCounter counter, qint64 amount = 1) {
+            if (isEnabled()) {
+                addCount(counter, amount);
+            }
+        }
+
+        // Returns the report as a human-readable table or as JSON
+        QByteArray tableReport();
+        QByteArray jsonReport();
+
+    } // namespace profiler
+
+    // Adds the time from its construction to its destruction, or to the call to stop(), to a stage
+    class ScopedStageTimer {
+    public:
+        explicit ScopedStageTimer(ProfileStage stage);
+        ~ScopedStageTimer();
+
+        void stop();
+
+        ScopedStageTimer(const ScopedStageTimer &other) = delete;
+        ScopedStageTimer &operator=(const ScopedStageTimer &other) = delete;
+
+    private:
+        ProfileStage m_stage;
+        ProfileStage m_previousStage;
+        bool m_enabled;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+} // namespace ygo
+
+#endif // PROFILER_H
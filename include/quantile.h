@@ -0,0 +1,38 @@
+#ifndef QUANTILE_H
+#define QUANTILE_H
+
+#include <vector>
+#include <QtGlobal>
+
+
+namespace ygo {
+
+    // Definitions of the value at a percentile p of n sorted values x[0..n-1]
+    enum class QuantileMethod {
+        Rounded,        // x[round(n * p / 100)], clamped to the last value
+        NearestRank,    // x[ceil(n * p / 100) - 1], clamped to the first value
+        Linear          // Linear interpolation between the values around (n - 1) * p / 100
+    };
+
+    // Frequency histogram of small non-negative counts, such as word or character counts. Any amount of percentiles
+    // can be queried in O(max count) each, without sorting the counts.
+    class CountHistogram {
+    public:
+        void add(int count);
+
+        qsizetype total() const { return m_total; }
+
+        // Returns the count at the given position of the sorted counts
+        int valueAt(qsizetype index) const;
+
+        // Returns the count at the given percentile (from 0-100), or 0 if the histogram is empty
+        double percentile(double percentile, QuantileMethod method) const;
+
+    private:
+        std::vector<qsizetype> m_frequencies;
+        qsizetype m_total = 0;
+    };
+
+} // namespace ygo
+
+#endif // QUANTILE_H
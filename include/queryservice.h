@@ -0,0 +1,62 @@
+#ifndef QUERYSERVICE_H
+#define QUERYSERVICE_H
+
+#include <memory>
+#include <vector>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QLocalServer>
+
+#include "pipeline.h"
+#include "parseutil.h"
+
+
+namespace ygo {
+
+    // Answers queries about a cardpool over a local socket (a Unix domain socket, or a named pipe on Windows). Each
+    // line a client sends is a JSON request, and each is answered by a line of JSON with the same "id". Requests are
+    // answered on the thread pool, so answers to a client may come back in any order.
+    //
+    //   {"id": 1, "query": "cards", "cards": [67284107, "Scapeghost"], "percentile": 25}
+    //       Word and character counts and limits of the cards, given by id or by name. When a percentile (and
+    //       optionally a "method" of "round", "nearest" or "linear") is given, also whether each card is within it.
+    //   {"id": 2, "query": "pool", "percentile": 37.5}
+    //       The cards within the percentile with their limits, and the excluded ids, as they would be written.
+    //
+    // The cardpool can be replaced at any time. Requests that are already being answered keep using the previous one.
+    class QueryService {
+    public:
+        QueryService();
+
+        QueryService(const QueryService &other) = delete;
+        QueryService &operator=(const QueryService &other) = delete;
+
+        // Starts listening for clients on the local socket with the given name, replacing any stale socket. Fails if
+        // another server is still listening on it.
+        bool listen(const QString &name);
+
+        void setCardpool(const Cardpool &pool, LFList previousLFList, LFList currentFormatLFList);
+
+        // Answers a single request line, without going through the socket
+        QByteArray answer(const QByteArray &request) const;
+
+    private:
+        struct State {
+            Cardpool pool;
+            LFList previousLFList;
+            LFList currentFormatLFList;
+            std::vector<int> limitsByGroup;
+        };
+
+        void acceptConnection();
+        static QByteArray answer(const std::shared_ptr<const State> &state, const QByteArray &request);
+        static QJsonObject answerCards(const State &state, const QJsonObject &request);
+        static QJsonObject answerPool(const State &state, const QJsonObject &request);
+
+        QLocalServer m_server;
+        std::shared_ptr<const State> m_state;
+    };
+
+} // namespace ygo
+
+#endif // QUERYSERVICE_H
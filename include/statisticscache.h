@@ -0,0 +1,59 @@
+#ifndef STATISTICSCACHE_H
+#define STATISTICSCACHE_H
+
+#include <optional>
+#include <QHash>
+#include <QByteArray>
+
+#include "cardstatistics.h"
+
+
+namespace ygo {
+
+    // On-disk cache of card statistics. Entries are keyed by card id and a hash of the card's description, card type
+    // and CardStatistics::RulesVersion, so an entry is ignored as soon as anything it was calculated from changes.
+    class StatisticsCache {
+    public:
+        // Simplified effects are only kept in the cache, in memory and on disk, when an arena is given, and are restored
+        // into it on lookup. Without one, the simplified effects of a cache file are dropped on load.
+        explicit StatisticsCache(SimplifiedEffectArena *effects = nullptr);
+
+        // The arena that statistics calculated for the cache should keep their simplified effects in, if any
+        SimplifiedEffectArena *simplifiedEffects() const { return m_effects; }
+
+        // Loads the cache file at path. A missing or outdated file leaves the cache empty.
+        bool load(const QString &path);
+
+        // Saves only the entries that were looked up or inserted since the cache was loaded, which drops the entries
+        // of cards that no longer exist
+        bool save(const QString &path) const;
+
+        // Returns the cached statistics of card, if its entry is up to date
+        std::optional<CardStatistics> lookup(const CardInfo &card);
+        void insert(const CardInfo &card, const CardStatistics &stats);
+
+        // Marks every entry as unused, so a cache that is kept across several builds of the cardpool only saves the
+        // entries of the latest one. Called before each build.
+        void resetUsage();
+
+        // Drops the entries that were not looked up or inserted since the last reset. Called after each build.
+        void dropUnused();
+
+    private:
+        struct Entry {
+            QByteArray hash;
+            QString simplifiedEffect;
+            int wordCount = 0;
+            int charCount = 0;
+            bool used = false;
+        };
+
+        static QByteArray hashCard(const CardInfo &card);
+
+        QHash<int, Entry> m_entries;
+        SimplifiedEffectArena *m_effects;
+    };
+
+} // namespace ygo
+
+#endif // STATISTICSCACHE_H
@@ -0,0 +1,43 @@
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <string>
+#include <string_view>
+#include <QString>
+#include <QStringView>
+
+
+namespace ygo {
+
+    // A string within a StringArena
+    struct StringRef {
+        quint32 offset = 0;
+        quint32 length = 0;
+    };
+
+    // Append-only UTF-8 storage for the text of many cards. The strings of a load are kept in one contiguous buffer
+    // instead of an allocation each, and are all freed at once along with the arena. A StringRef stays valid as the
+    // arena grows, but the views it hands out do not.
+    class StringArena {
+    public:
+        StringRef append(std::string_view text);
+        StringRef append(QStringView text);
+
+        std::string_view view(StringRef ref) const { return std::string_view(m_data.data() + ref.offset, ref.length); }
+        QString text(StringRef ref) const;
+
+        qsizetype size() const { return static_cast<qsizetype>(m_data.size()); }
+        void reserve(qsizetype size) { m_data.reserve(static_cast<size_t>(size)); }
+
+    private:
+        std::string m_data;
+    };
+
+    // Returns UTF-8 text, such as a string from an arena, as a QString
+    inline QString toQString(std::string_view text) {
+        return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+    }
+
+} // namespace ygo
+
+#endif // STRINGARENA_H
@@ -0,0 +1,34 @@
+#ifndef TEXTKERNELS_H
+#define TEXTKERNELS_H
+
+#include <QString>
+#include <QStringView>
+
+
+namespace ygo {
+
+    // Character class kernels for card text. Each has a scalar implementation and, on x86, SSE2 and AVX2
+    // implementations that are chosen at runtime depending on what the CPU supports.
+
+    // Returns the amount of characters in text that are not line breaks (\r or \n), counting a surrogate pair as a
+    // single character. Same as text.count(QRegularExpression("[^\r\n]")).
+    qsizetype countNonLineBreakChars(QStringView text);
+
+    // Returns text with every run of two or more spaces collapsed into a single space and whitespace trimmed from both
+    // ends. Same as text.replace(QRegularExpression(" {2,}"), " ").trimmed().
+    QString collapseSpacesAndTrim(QStringView text);
+
+    namespace kernels {
+
+        // Counts the \r, \n and low surrogate code units in data
+        qsizetype countLineBreaksAndLowSurrogates(const char16_t *data, qsizetype length);
+
+        // Copies data to out, dropping every space that follows another space. Returns the amount of code units
+        // written, out must have room for length code units.
+        qsizetype collapseSpaces(const char16_t *data, qsizetype length, char16_t *out);
+
+    } // namespace kernels
+
+} // namespace ygo
+
+#endif // TEXTKERNELS_H
@@ -0,0 +1,38 @@
+#ifndef WORDSCANNER_H
+#define WORDSCANNER_H
+
+#include <QStringView>
+
+
+namespace ygo {
+
+    // Finds the words of a text exactly as the regular expression \b[\w']+\b(-[\w']+\b)* would match them, where \w
+    // is an ASCII letter, digit or underscore (QRegularExpression's default). Apostrophes are allowed within words,
+    // and hyphenated compounds count as a single word. The text is scanned once without allocating.
+    class WordScanner {
+    public:
+        explicit WordScanner(QStringView text);
+
+        // Moves to the next word, returning false once there are no words left
+        bool next();
+
+        QStringView word() const { return m_text.mid(m_wordStart, m_wordEnd - m_wordStart); }
+        qsizetype wordStart() const { return m_wordStart; }
+        qsizetype wordEnd() const { return m_wordEnd; }
+
+    private:
+        bool isBoundary(qsizetype position) const;
+        qsizetype matchRun(qsizetype from, qsizetype *runEnd) const;
+
+        QStringView m_text;
+        qsizetype m_position;
+        qsizetype m_wordStart;
+        qsizetype m_wordEnd;
+    };
+
+    // Returns the amount of words in text, as found by WordScanner
+    int countWords(QStringView text);
+
+} // namespace ygo
+
+#endif // WORDSCANNER_H
@@ -0,0 +1,137 @@
+// Heap allocation hooks for the --profile report, only compiled into builds with YGOPFG_ALLOC_TRACKING. On glibc the
+// malloc family itself is replaced, which also covers the QString and QMap data that Qt allocates with malloc rather
+// than operator new. Elsewhere only the global operator new and delete are replaced.
+
+#ifdef YGOPFG_ALLOC_TRACKING
+
+#include "profiler.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+
+#include <malloc.h>
+
+// The replacements are declared __THROW to match the declarations of the C library headers
+extern "C" {
+
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *ptr);
+
+    static void *recordAllocation(void *ptr) {
+        if (ptr) {
+            ygo::profiler::recordAllocation(malloc_usable_size(ptr));
+        }
+        return ptr;
+    }
+
+    static void recordDeallocation(void *ptr) {
+        if (ptr) {
+            ygo::profiler::recordDeallocation(malloc_usable_size(ptr));
+        }
+    }
+
+    void *malloc(size_t size) __THROW {
+        return recordAllocation(__libc_malloc(size));
+    }
+
+    void *calloc(size_t count, size_t size) __THROW {
+        return recordAllocation(__libc_calloc(count, size));
+    }
+
+    // Reallocations count as a new allocation of the full size, even when the block grows in place
+    void *realloc(void *ptr, size_t size) __THROW {
+        const size_t previousSize = ptr ? malloc_usable_size(ptr) : 0;
+        void *result = __libc_realloc(ptr, size);
+
+        // The original block is left untouched when the reallocation fails
+        if (result || size == 0) {
+            ygo::profiler::recordDeallocation(previousSize);
+        }
+        return recordAllocation(result);
+    }
+
+    void *memalign(size_t alignment, size_t size) __THROW {
+        return recordAllocation(__libc_memalign(alignment, size));
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size) __THROW {
+        return recordAllocation(__libc_memalign(alignment, size));
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size) __THROW {
+        void *result = __libc_memalign(alignment, size);
+        if (!result) {
+            return ENOMEM;
+        }
+        *ptr = recordAllocation(result);
+        return 0;
+    }
+
+    void free(void *ptr) __THROW {
+        recordDeallocation(ptr);
+        __libc_free(ptr);
+    }
+
+} // extern "C"
+
+#else
+
+// Without the size of freed blocks, only the amount and size of allocations are counted
+static void *allocate(std::size_t size) {
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    ygo::profiler::recordAllocation(size);
+    return ptr;
+}
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif
+
+#endif // YGOPFG_ALLOC_TRACKING
@@ -0,0 +1,109 @@
+#include "cardgroups.h"
+
+
+namespace ygo {
+
+    static bool findLimit(CardGroupIndex::IdRange ids, const QHash<int, int> &limitsById, int *limit);
+
+
+    void CardGroupIndex::build(const CardTable &cards, const QMultiMap<int, int> &excludedIdsByAlias) {
+        *this = CardGroupIndex();
+
+        // Number the groups in id order and count the ids of each
+        std::vector<int> idCounts;
+        m_groupsByRow.reserve(cards.count());
+        m_groupsByName.reserve(cards.count());
+        for (int row = 0; row < cards.count(); ++row) {
+            const auto inserted = m_groupsByName.emplace(cards.name(row), groupCount());
+            const int group = inserted.first->second;
+            if (inserted.second) {
+                m_baseIds.push_back(0);
+                idCounts.push_back(0);
+            }
+
+            m_groupsByRow.push_back(group);
+            m_groupsById.insert(cards.id(row), group);
+            ++idCounts[group];
+            if (cards.alias(row) == 0) {
+                m_baseIds[group] = cards.id(row);
+            }
+        }
+
+        m_idOffsets.resize(groupCount() + 1, 0);
+        for (int group = 0; group < groupCount(); ++group) {
+            m_idOffsets[group + 1] = m_idOffsets[group] + idCounts[group];
+        }
+
+        // Fill every group from its end, so that the ids of a group end up highest first
+        m_ids.resize(m_idOffsets.back());
+        std::vector<int> ends(m_idOffsets.begin() + 1, m_idOffsets.end());
+        for (int row = 0; row < cards.count(); ++row) {
+            m_ids[--ends[m_groupsByRow[row]]] = cards.id(row);
+        }
+
+        // The excluded versions are kept in the order they are written in
+        m_excludedOffsets.reserve(groupCount() + 1);
+        for (int group = 0; group < groupCount(); ++group) {
+            m_excludedOffsets.push_back(static_cast<int>(m_excludedIds.size()));
+            if (m_baseIds[group] == 0) {
+                continue;
+            }
+
+            const auto excluded = excludedIdsByAlias.equal_range(m_baseIds[group]);
+            for (auto it = excluded.first; it != excluded.second; ++it) {
+                m_excludedIds.push_back(it.value());
+                m_groupsById.insert(it.value(), group);
+            }
+        }
+        m_excludedOffsets.push_back(static_cast<int>(m_excludedIds.size()));
+    }
+
+    int CardGroupIndex::groupOf(std::string_view name) const {
+        const auto it = m_groupsByName.find(name);
+        return it != m_groupsByName.cend() ? it->second : -1;
+    }
+
+    int CardGroupIndex::groupOf(const QString &name) const {
+        const QByteArray utf8 = name.toUtf8();
+        return groupOf(std::string_view(utf8.constData(), static_cast<size_t>(utf8.size())));
+    }
+
+    CardGroupIndex::IdRange CardGroupIndex::ids(int group) const {
+        return IdRange(m_ids.data() + m_idOffsets[group], m_ids.data() + m_idOffsets[group + 1]);
+    }
+
+    CardGroupIndex::IdRange CardGroupIndex::excludedIds(int group) const {
+        return IdRange(m_excludedIds.data() + m_excludedOffsets[group], m_excludedIds.data() + m_excludedOffsets[group + 1]);
+    }
+
+    int CardGroupIndex::resolveLimit(int group, const LFList &previousLFList, const LFList &currentFormatLFList) const {
+        int limit = 3;
+        if (!findLimit(ids(group), previousLFList.limitsById, &limit)) {
+            findLimit(ids(group), currentFormatLFList.limitsById, &limit);
+        }
+
+        return limit;
+    }
+
+    std::vector<int> CardGroupIndex::resolveLimits(const LFList &previousLFList, const LFList &currentFormatLFList) const {
+        std::vector<int> limits(groupCount());
+        for (int group = 0; group < groupCount(); ++group) {
+            limits[group] = resolveLimit(group, previousLFList, currentFormatLFList);
+        }
+
+        return limits;
+    }
+
+    bool findLimit(CardGroupIndex::IdRange ids, const QHash<int, int> &limitsById, int *limit) {
+        for (const auto id : ids) {
+            const auto it = limitsById.constFind(id);
+            if (it != limitsById.constEnd()) {
+                *limit = it.value();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+} // namespace ygo
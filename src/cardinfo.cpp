@@ -3,10 +3,26 @@
 
 namespace ygo {
 
-    CardInfo::CardInfo()
-        : m_cardType(NullType),
+    CardInfo::CardInfo(std::shared_ptr<StringArena> strings)
+        : m_strings(std::move(strings)),
+          m_cardType(NullType),
           m_id(0),
-          m_ot(0)
+          m_ot(0),
+          m_alias(0),
+          m_stringsWritable(true)
+    {
+
+    }
+
+    CardInfo::CardInfo(std::shared_ptr<const StringArena> strings, StringRef name, StringRef description)
+        : m_strings(std::move(strings)),
+          m_name(name),
+          m_description(description),
+          m_cardType(NullType),
+          m_id(0),
+          m_ot(0),
+          m_alias(0),
+          m_stringsWritable(false)
     {
 
     }
@@ -27,12 +43,36 @@ namespace ygo {
         m_cardType = cardType;
     }
 
+    QString CardInfo::name() const {
+        return toQString(nameUtf8());
+    }
+
+    std::string_view CardInfo::nameUtf8() const {
+        return m_strings ? m_strings->view(m_name) : std::string_view();
+    }
+
     void CardInfo::setName(const QString &name) {
-        m_name = name;
+        m_name = strings().append(QStringView(name));
+    }
+
+    void CardInfo::setNameUtf8(std::string_view name) {
+        m_name = strings().append(name);
+    }
+
+    QString CardInfo::description() const {
+        return toQString(descriptionUtf8());
+    }
+
+    std::string_view CardInfo::descriptionUtf8() const {
+        return m_strings ? m_strings->view(m_description) : std::string_view();
     }
 
     void CardInfo::setDescription(const QString &description) {
-        m_description = description;
+        m_description = strings().append(QStringView(description));
+    }
+
+    void CardInfo::setDescriptionUtf8(std::string_view description) {
+        m_description = strings().append(description);
     }
 
     bool CardInfo::hasEffect() const {
@@ -40,7 +80,7 @@ namespace ygo {
             return true;
         } else if (cardType() & ygo::Pendulum) {
             // Only normal pendulums will reach here, so we only check if the card has a pendulum effect
-            if (description().contains("[ Pendulum Effect ]")) {
+            if (descriptionUtf8().find("[ Pendulum Effect ]") != std::string_view::npos) {
                 return true;
             } else {
                 return false;
@@ -50,4 +90,22 @@ namespace ygo {
         }
     }
 
+    std::shared_ptr<const StringArena> CardInfo::sharedStrings() const {
+        return m_stringsWritable ? std::shared_ptr<const StringArena>() : m_strings;
+    }
+
+    StringArena &CardInfo::strings() {
+        // A read-only arena is left as it is, and the text of the card copied out of it first
+        if (!m_strings || !m_stringsWritable) {
+            auto strings = std::make_shared<StringArena>();
+            m_name = strings->append(nameUtf8());
+            m_description = strings->append(descriptionUtf8());
+            m_strings = strings;
+            m_stringsWritable = true;
+        }
+
+        // Only arenas that were created writable are written to
+        return const_cast<StringArena &>(*m_strings);
+    }
+
 }
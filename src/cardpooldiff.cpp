@@ -0,0 +1,121 @@
+#include "cardpooldiff.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+
+
+namespace ygo {
+
+    CardpoolDiff diffCardpool(const QHash<int, int> &limitsById,
+                              const QList<int> &excludedIds,
+                              const QHash<int, int> &previousLimitsById,
+                              const QList<int> &previousExcludedIds) {
+        CardpoolDiff diff;
+
+        for (auto it = limitsById.cbegin(); it != limitsById.cend(); ++it) {
+            const auto previous = previousLimitsById.constFind(it.key());
+            if (previous == previousLimitsById.cend()) {
+                diff.addedIds.append(it.key());
+            } else if (previous.value() != it.value()) {
+                diff.limitChanges.append({ it.key(), previous.value(), it.value() });
+            }
+        }
+
+        for (auto it = previousLimitsById.cbegin(); it != previousLimitsById.cend(); ++it) {
+            if (!limitsById.contains(it.key())) {
+                diff.removedIds.append(it.key());
+            }
+        }
+
+        const QSet<int> excluded(excludedIds.cbegin(), excludedIds.cend());
+        const QSet<int> previousExcluded(previousExcludedIds.cbegin(), previousExcludedIds.cend());
+        for (const auto id : excluded) {
+            if (!previousExcluded.contains(id)) {
+                diff.newlyExcludedIds.append(id);
+            }
+        }
+        for (const auto id : previousExcluded) {
+            if (!excluded.contains(id)) {
+                diff.noLongerExcludedIds.append(id);
+            }
+        }
+
+        // Hash order is arbitrary, so sort everything for a stable report
+        std::sort(diff.addedIds.begin(), diff.addedIds.end());
+        std::sort(diff.removedIds.begin(), diff.removedIds.end());
+        std::sort(diff.limitChanges.begin(), diff.limitChanges.end(), [](const LimitChange &a, const LimitChange &b) {
+            return a.id < b.id;
+        });
+        std::sort(diff.newlyExcludedIds.begin(), diff.newlyExcludedIds.end());
+        std::sort(diff.noLongerExcludedIds.begin(), diff.noLongerExcludedIds.end());
+
+        return diff;
+    }
+
+    static QJsonObject cardObject(int id, const CardTable &cards) {
+        QJsonObject card { { "id", id } };
+        const int row = cards.rowOf(id);
+        if (row >= 0) {
+            card.insert("name", toQString(cards.name(row)));
+        }
+        return card;
+    }
+
+    static QJsonArray idArray(const QList<int> &ids) {
+        QJsonArray array;
+        for (const auto id : ids) {
+            array.append(id);
+        }
+        return array;
+    }
+
+    bool writeCardpoolDiffReport(const QString &path,
+                                 const QString &formatName,
+                                 const CardpoolDiff &diff,
+                                 const CardTable &cards) {
+        QJsonArray added;
+        for (const auto id : diff.addedIds) {
+            added.append(cardObject(id, cards));
+        }
+
+        QJsonArray removed;
+        for (const auto id : diff.removedIds) {
+            removed.append(cardObject(id, cards));
+        }
+
+        QJsonArray limitChanges;
+        for (const auto &change : diff.limitChanges) {
+            auto card = cardObject(change.id, cards);
+            card.insert("previousLimit", change.previousLimit);
+            card.insert("limit", change.limit);
+            limitChanges.append(card);
+        }
+
+        const QJsonObject report {
+            { "format", formatName },
+            { "added", added },
+            { "removed", removed },
+            { "limitChanges", limitChanges },
+            { "excluded", QJsonObject {
+                { "added", idArray(diff.newlyExcludedIds) },
+                { "removed", idArray(diff.noLongerExcludedIds) }
+            } }
+        };
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cout << "Could not open the diff report file: " << path.toStdString() << '\n';
+            return false;
+        }
+
+        profiler::count(ProfileCounter::BytesWritten, file.write(QJsonDocument(report).toJson()));
+        return file.commit();
+    }
+
+} // namespace ygo
@@ -0,0 +1,240 @@
+#include "cardsnapshot.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+
+namespace ygo {
+
+    static const quint32 snapshotMagic = 0x59474353; // "YGCS"
+    static const quint32 snapshotFormatVersion = 2;
+    static const quint32 snapshotByteOrder = 0x01020304;
+
+    // The snapshot is a header followed by the sources, the card columns, the excluded ids and the string blob. Values
+    // are stored in the byte order of the machine that wrote them, so they can be used straight from the mapped file.
+    // A snapshot from a machine of another byte order is simply rebuilt.
+    struct SnapshotHeader {
+        quint32 magic;
+        quint32 formatVersion;
+        quint32 byteOrder;
+        quint32 sourceCount;
+        quint32 cardCount;
+        quint32 excludedCount;      // Pairs of alias and id, in QMultiMap order
+        quint64 sourcesOffset;
+        quint64 cardsOffset;
+        quint64 excludedOffset;
+        quint64 stringsOffset;
+        quint64 stringsLength;      // In bytes of UTF-8
+        quint64 fileSize;
+    };
+
+    struct SnapshotSourceEntry {
+        qint64 size;
+        qint64 lastModified;
+        quint32 pathOffset;
+        quint32 pathLength;
+    };
+
+    // The card columns, each cardCount values long and stored one after another in this order
+    enum SnapshotColumn {
+        IdColumn,
+        OtColumn,
+        AliasColumn,
+        TypeColumn,
+        NameOffsetColumn,
+        NameLengthColumn,
+        DescriptionOffsetColumn,
+        DescriptionLengthColumn,
+        ColumnCount
+    };
+
+    static bool sectionFits(quint64 offset, quint64 size, quint64 fileSize);
+    static quint32 appendString(std::string *strings, std::string_view text);
+    static bool writeData(QSaveFile *file, const void *data, quint64 size);
+
+
+    QList<SnapshotSource> snapshotSources(const QString &dbPath) {
+        QList<SnapshotSource> sources;
+        for (const auto &file : QDir(dbPath).entryInfoList({ "*.cdb" }, QDir::Files)) {
+            sources.append({ file.filePath(), file.size(), file.lastModified().toMSecsSinceEpoch() });
+        }
+
+        return sources;
+    }
+
+    bool loadCardSnapshot(const QString &path, const QList<SnapshotSource> &sources,
+                          QMap<int, CardInfo> *cardsById, QMultiMap<int, int> *excludedIdsByAlias) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(SnapshotHeader))) {
+            return false;
+        }
+
+        const uchar *data = file.map(0, file.size());
+        if (!data) {
+            return false;
+        }
+
+        // Check the header, and that every section lies within the file
+        SnapshotHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        const quint64 fileSize = file.size();
+        if (header.magic != snapshotMagic || header.formatVersion != snapshotFormatVersion
+            || header.byteOrder != snapshotByteOrder || header.fileSize != fileSize
+            || !sectionFits(header.sourcesOffset, header.sourceCount * quint64(sizeof(SnapshotSourceEntry)), fileSize)
+            || !sectionFits(header.cardsOffset, header.cardCount * quint64(ColumnCount * sizeof(quint32)), fileSize)
+            || !sectionFits(header.excludedOffset, header.excludedCount * quint64(2 * sizeof(qint32)), fileSize)
+            || !sectionFits(header.stringsOffset, header.stringsLength, fileSize)) {
+            return false;
+        }
+
+        const auto *strings = reinterpret_cast<const char *>(data + header.stringsOffset);
+        const auto fitsStrings = [&](quint32 offset, quint32 length) {
+            return quint64(offset) + length <= header.stringsLength;
+        };
+
+        // The snapshot is only used when it was made from exactly the databases that are there now
+        const auto *sourceEntries = reinterpret_cast<const SnapshotSourceEntry *>(data + header.sourcesOffset);
+        if (header.sourceCount != static_cast<quint32>(sources.count())) {
+            return false;
+        }
+        for (int i = 0; i < sources.count(); ++i) {
+            const auto &entry = sourceEntries[i];
+            const QByteArray path = sources.at(i).path.toUtf8();
+            if (entry.size != sources.at(i).size || entry.lastModified != sources.at(i).lastModified
+                || !fitsStrings(entry.pathOffset, entry.pathLength)
+                || std::string_view(strings + entry.pathOffset, entry.pathLength) != std::string_view(path.constData(), path.size())) {
+                return false;
+            }
+        }
+
+        const auto *columns = reinterpret_cast<const quint32 *>(data + header.cardsOffset);
+        const auto column = [&](SnapshotColumn index) {
+            return columns + quint64(index) * header.cardCount;
+        };
+
+        const quint32 *ids = column(IdColumn);
+        const quint32 *ots = column(OtColumn);
+        const quint32 *aliases = column(AliasColumn);
+        const quint32 *types = column(TypeColumn);
+        const quint32 *nameOffsets = column(NameOffsetColumn);
+        const quint32 *nameLengths = column(NameLengthColumn);
+        const quint32 *descriptionOffsets = column(DescriptionOffsetColumn);
+        const quint32 *descriptionLengths = column(DescriptionLengthColumn);
+
+        for (quint32 i = 0; i < header.cardCount; ++i) {
+            if (!fitsStrings(nameOffsets[i], nameLengths[i]) || !fitsStrings(descriptionOffsets[i], descriptionLengths[i])) {
+                return false;
+            }
+        }
+
+        // The strings are copied into a single arena as a whole, where every card refers to them at the same offsets.
+        // The cards are stored in id order, so every card is appended to the end of the map and moved into its place.
+        const auto arena = std::make_shared<StringArena>();
+        arena->append(std::string_view(strings, header.stringsLength));
+        for (quint32 i = 0; i < header.cardCount; ++i) {
+            CardInfo card(arena, { nameOffsets[i], nameLengths[i] }, { descriptionOffsets[i], descriptionLengths[i] });
+            card.setId(static_cast<qint32>(ids[i]));
+            card.setOt(static_cast<qint32>(ots[i]));
+            card.setAlias(static_cast<qint32>(aliases[i]));
+            card.setCardType(CardType(types[i]));
+            *cardsById->insert(cardsById->cend(), card.id(), CardInfo()) = std::move(card);
+        }
+
+        // Inserting a value puts it before the values already stored under its key, so the pairs are inserted in
+        // reverse to keep the order they were saved in
+        const auto *excluded = reinterpret_cast<const qint32 *>(data + header.excludedOffset);
+        for (quint32 i = header.excludedCount; i > 0; --i) {
+            excludedIdsByAlias->insert(excluded[2 * (i - 1)], excluded[2 * (i - 1) + 1]);
+        }
+
+        return true;
+    }
+
+    bool saveCardSnapshot(const QString &path, const QList<SnapshotSource> &sources,
+                          const QMap<int, CardInfo> &cardsById, const QMultiMap<int, int> &excludedIdsByAlias) {
+        std::string strings;
+        std::vector<SnapshotSourceEntry> sourceEntries;
+        for (const auto &source : sources) {
+            const QByteArray path = source.path.toUtf8();
+            const quint32 pathOffset = appendString(&strings, std::string_view(path.constData(), path.size()));
+            sourceEntries.push_back({ source.size, source.lastModified, pathOffset, static_cast<quint32>(path.size()) });
+        }
+
+        const quint64 cardCount = cardsById.count();
+        std::vector<quint32> columns(ColumnCount * cardCount);
+        quint64 row = 0;
+        for (const auto &card : cardsById) {
+            const auto name = card.nameUtf8();
+            const auto description = card.descriptionUtf8();
+            columns[IdColumn * cardCount + row] = static_cast<quint32>(card.id());
+            columns[OtColumn * cardCount + row] = static_cast<quint32>(card.ot());
+            columns[AliasColumn * cardCount + row] = static_cast<quint32>(card.alias());
+            columns[TypeColumn * cardCount + row] = static_cast<quint32>(card.cardType());
+            columns[NameOffsetColumn * cardCount + row] = appendString(&strings, name);
+            columns[NameLengthColumn * cardCount + row] = static_cast<quint32>(name.size());
+            columns[DescriptionOffsetColumn * cardCount + row] = appendString(&strings, description);
+            columns[DescriptionLengthColumn * cardCount + row] = static_cast<quint32>(description.size());
+            ++row;
+        }
+
+        std::vector<qint32> excluded;
+        excluded.reserve(2 * excludedIdsByAlias.count());
+        for (auto it = excludedIdsByAlias.cbegin(); it != excludedIdsByAlias.cend(); ++it) {
+            excluded.push_back(it.key());
+            excluded.push_back(it.value());
+        }
+
+        SnapshotHeader header = {};
+        header.magic = snapshotMagic;
+        header.formatVersion = snapshotFormatVersion;
+        header.byteOrder = snapshotByteOrder;
+        header.sourceCount = static_cast<quint32>(sourceEntries.size());
+        header.cardCount = static_cast<quint32>(cardCount);
+        header.excludedCount = static_cast<quint32>(excluded.size() / 2);
+        header.sourcesOffset = sizeof(SnapshotHeader);
+        header.cardsOffset = header.sourcesOffset + sourceEntries.size() * sizeof(SnapshotSourceEntry);
+        header.excludedOffset = header.cardsOffset + columns.size() * sizeof(quint32);
+        header.stringsOffset = header.excludedOffset + excluded.size() * sizeof(qint32);
+        header.stringsLength = strings.size();
+        header.fileSize = header.stringsOffset + header.stringsLength;
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cout << "Could not open the card snapshot for writing: " << path.toStdString() << '\n';
+            return false;
+        }
+
+        if (!writeData(&file, &header, sizeof(header))
+            || !writeData(&file, sourceEntries.data(), sourceEntries.size() * sizeof(SnapshotSourceEntry))
+            || !writeData(&file, columns.data(), columns.size() * sizeof(quint32))
+            || !writeData(&file, excluded.data(), excluded.size() * sizeof(qint32))
+            || !writeData(&file, strings.data(), strings.size())
+            || !file.commit()) {
+            std::cout << "Could not write the card snapshot: " << path.toStdString() << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    bool sectionFits(quint64 offset, quint64 size, quint64 fileSize) {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+
+    quint32 appendString(std::string *strings, std::string_view text) {
+        const auto offset = static_cast<quint32>(strings->size());
+        strings->append(text);
+        return offset;
+    }
+
+    bool writeData(QSaveFile *file, const void *data, quint64 size) {
+        return size == 0 || file->write(static_cast<const char *>(data), static_cast<qint64>(size)) == static_cast<qint64>(size);
+    }
+
+} // namespace ygo
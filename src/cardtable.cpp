@@ -0,0 +1,110 @@
+#include "cardtable.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace ygo {
+
+    void CardTable::build(const QMap<int, CardInfo> &allCardsById) {
+        *this = CardTable();
+
+        const size_t cardCount = static_cast<size_t>(allCardsById.count());
+        m_ids.reserve(cardCount);
+        m_ots.reserve(cardCount);
+        m_aliases.reserve(cardCount);
+        m_cardTypes.reserve(cardCount);
+        m_arenaIndexes.reserve(cardCount);
+        m_names.reserve(cardCount);
+        m_descriptions.reserve(cardCount);
+        m_hasEffect.reserve(cardCount);
+
+        // The text of cards without a read-only arena is copied into the first arena, sized for all of it up front
+        const auto ownStrings = std::make_shared<StringArena>();
+        qsizetype ownLength = 0;
+        for (const auto &card : allCardsById) {
+            if (!card.sharedStrings()) {
+                ownLength += static_cast<qsizetype>(card.nameUtf8().size() + card.descriptionUtf8().size());
+            }
+        }
+        ownStrings->reserve(ownLength);
+        m_arenas.push_back(ownStrings);
+
+        std::unordered_map<const StringArena *, int> arenaIndexes;
+        std::vector<int> effectRows;
+        std::vector<int> nonEffectRows;
+        for (const auto &card : allCardsById) {
+            if (card.cardType() & Token || card.ot() == 8) {
+                continue;
+            }
+
+            const int row = count();
+            const bool hasEffect = card.hasEffect();
+            m_ids.push_back(card.id());
+            m_ots.push_back(card.ot());
+            m_aliases.push_back(card.alias());
+            m_cardTypes.push_back(card.cardType());
+            if (auto strings = card.sharedStrings()) {
+                const auto inserted = arenaIndexes.emplace(strings.get(), static_cast<int>(m_arenas.size()));
+                if (inserted.second) {
+                    m_arenas.push_back(std::move(strings));
+                }
+                m_arenaIndexes.push_back(inserted.first->second);
+                m_names.push_back(card.nameRef());
+                m_descriptions.push_back(card.descriptionRef());
+            } else {
+                m_arenaIndexes.push_back(0);
+                m_names.push_back(ownStrings->append(card.nameUtf8()));
+                m_descriptions.push_back(ownStrings->append(card.descriptionUtf8()));
+            }
+            m_hasEffect.push_back(hasEffect);
+
+            if (card.alias() == 0) {
+                (hasEffect ? effectRows : nonEffectRows).push_back(row);
+            }
+        }
+
+        m_wordCounts.resize(count(), 0);
+        m_charCounts.resize(count(), 0);
+
+        // The rows are in id order, so the base card with the highest id is kept for each name
+        m_effectRows = sortedByName(std::move(effectRows));
+        m_nonEffectRows = sortedByName(std::move(nonEffectRows));
+    }
+
+    int CardTable::rowOf(int id) const {
+        const auto it = std::lower_bound(m_ids.cbegin(), m_ids.cend(), id);
+        return it != m_ids.cend() && *it == id ? static_cast<int>(it - m_ids.cbegin()) : -1;
+    }
+
+    void CardTable::setCounts(int row, int wordCount, int charCount) {
+        m_wordCounts[row] = wordCount;
+        m_charCounts[row] = charCount;
+    }
+
+    CardInfo CardTable::card(int row) const {
+        CardInfo card(m_arenas[m_arenaIndexes[row]], m_names[row], m_descriptions[row]);
+        card.setId(m_ids[row]);
+        card.setOt(m_ots[row]);
+        card.setAlias(m_aliases[row]);
+        card.setCardType(m_cardTypes[row]);
+        return card;
+    }
+
+    std::vector<int> CardTable::sortedByName(std::vector<int> rows) const {
+        std::stable_sort(rows.begin(), rows.end(), [this](int a, int b) {
+            return name(a) < name(b);
+        });
+
+        std::vector<int> unique;
+        unique.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (i + 1 == rows.size() || name(rows[i]) != name(rows[i + 1])) {
+                unique.push_back(rows[i]);
+            }
+        }
+
+        return unique;
+    }
+
+} // namespace ygo
@@ -1,6 +1,13 @@
 #include "commandline.h"
+#include "parseutil.h"
 
 #include <iostream>
+#include <QRegularExpression>
+
+
+static bool parsePercentile(const QString &text, double *percentile);
+static bool parseQuantileMethod(const QString &text, ygo::QuantileMethod *method);
+static bool parseBatchFile(const QString &path, const CommandFlags &flags, QList<FormatOptions> *formats);
 
 
 QStringList getArguments(int argc, char *argv[]) {
@@ -21,13 +28,10 @@ CommandFlags parseCommandFlags(const QStringList &args) {
 
     for (int i = 1; i < args.length(); ++i) {
         if (args.at(i) == "-p" && i < args.length() - 1) {
-            bool convertedSuccessfully = false;
-            const double percentile = args.at(++i).toDouble(&convertedSuccessfully);
-            if (!convertedSuccessfully || percentile < 0 || percentile > 100) {
+            if (!parsePercentile(args.at(++i), &flags.percentile)) {
                 flags.helpNeeded = true;
                 break;
             }
-            flags.percentile = percentile;
         } else if (args.at(i) == "-d" && i < args.length() - 1) {
             flags.dbPath = args.at(++i);
         } else if (args.at(i) == "-o" && i < args.length() - 1) {
@@ -36,19 +40,144 @@ CommandFlags parseCommandFlags(const QStringList &args) {
             flags.prevLFList = args.at(++i);
         } else if (args.at(i) == "-c" && i < args.length() - 1) {
             flags.currentFormatLFList = args.at(++i);
+        } else if (args.at(i) == "-b" && i < args.length() - 1) {
+            flags.batchFile = args.at(++i);
+        } else if (args.at(i) == "-s" && i < args.length() - 1) {
+            flags.statisticsCache = args.at(++i);
+        } else if (args.at(i) == "-q" && i < args.length() - 1) {
+            if (!parseQuantileMethod(args.at(++i), &flags.quantileMethod)) {
+                flags.helpNeeded = true;
+                break;
+            }
+        } else if (args.at(i) == "--snapshot" && i < args.length() - 1) {
+            flags.snapshot = args.at(++i);
+        } else if (args.at(i) == "--export-effects" && i < args.length() - 1) {
+            flags.exportEffects = args.at(++i);
+        } else if (args.at(i) == "--profile" && i < args.length() - 1) {
+            flags.profileFormat = args.at(++i);
+            if (flags.profileFormat != "table" && flags.profileFormat != "json") {
+                flags.helpNeeded = true;
+                break;
+            }
+        } else if (args.at(i) == "--serve" && i < args.length() - 1) {
+            flags.serveName = args.at(++i);
+        } else if (args.at(i) == "-a") {
+            flags.attachDatabases = true;
+        } else if (args.at(i) == "-w") {
+            flags.watch = true;
         } else {
             flags.helpNeeded = true;
             break;
         }
     }
 
-    if (flags.dbPath.isEmpty() || flags.outputLFList.isEmpty()) {
+    // Serving keeps the cardpool up to date the same way watch mode does
+    if (!flags.serveName.isEmpty()) {
+        flags.watch = true;
+    }
+
+    // Watch mode keeps the cards of each database apart, so it reloads them one file at a time instead of attaching
+    // them or loading a snapshot of them all. Simplified effects are only exported from a single load.
+    if (flags.helpNeeded || flags.dbPath.isEmpty()
+        || (flags.watch && (flags.attachDatabases || !flags.snapshot.isEmpty() || !flags.exportEffects.isEmpty()))) {
+        flags.helpNeeded = true;
+        return flags;
+    }
+
+    // A single format may be given directly on the command line, alongside any formats in the batch file
+    if (!flags.outputLFList.isEmpty() || flags.percentile >= 0) {
+        if (flags.outputLFList.isEmpty() || flags.percentile < 0) {
+            flags.helpNeeded = true;
+            return flags;
+        }
+        flags.formats.append({ flags.outputLFList, flags.prevLFList, flags.currentFormatLFList, flags.percentile, flags.quantileMethod });
+    }
+
+    if (!flags.batchFile.isEmpty() && !parseBatchFile(flags.batchFile, flags, &flags.formats)) {
+        flags.helpNeeded = true;
+        return flags;
+    }
+
+    // A server may answer queries, and an export may be written, without generating any lflists
+    if (flags.formats.isEmpty() && flags.serveName.isEmpty() && flags.exportEffects.isEmpty()) {
         flags.helpNeeded = true;
     }
 
     return flags;
 }
 
+bool parsePercentile(const QString &text, double *percentile) {
+    bool convertedSuccessfully = false;
+    const double value = text.toDouble(&convertedSuccessfully);
+    if (!convertedSuccessfully || value < 0 || value > 100) {
+        return false;
+    }
+
+    *percentile = value;
+    return true;
+}
+
+bool parseQuantileMethod(const QString &text, ygo::QuantileMethod *method) {
+    if (text == "round") {
+        *method = ygo::QuantileMethod::Rounded;
+    } else if (text == "nearest") {
+        *method = ygo::QuantileMethod::NearestRank;
+    } else if (text == "linear") {
+        *method = ygo::QuantileMethod::Linear;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+// Each non-blank line of a batch file describes one format (Ex: 25 25th.conf -l prev25th.conf -c current.conf).
+// The -l and -c files default to the ones given on the command line.
+bool parseBatchFile(const QString &path, const CommandFlags &flags, QList<FormatOptions> *formats) {
+    const auto text = readTextFile(path);
+    if (text.isEmpty()) {
+        return false;
+    }
+
+    static const QRegularExpression re_whitespace(R"(\s+)");
+    for (const auto &line : text.split('\n', Qt::SkipEmptyParts)) {
+        if (line.startsWith('#')) {
+            continue;
+        }
+
+        const auto fields = line.split(re_whitespace, Qt::SkipEmptyParts);
+        if (fields.length() < 2) {
+            std::cout << "Invalid batch line: " << line.toStdString() << '\n';
+            return false;
+        }
+
+        FormatOptions format;
+        format.outputLFList = fields.at(1);
+        format.prevLFList = flags.prevLFList;
+        format.currentFormatLFList = flags.currentFormatLFList;
+        format.quantileMethod = flags.quantileMethod;
+        if (!parsePercentile(fields.at(0), &format.percentile)) {
+            std::cout << "Invalid batch line: " << line.toStdString() << '\n';
+            return false;
+        }
+
+        for (int i = 2; i < fields.length(); ++i) {
+            if (fields.at(i) == "-l" && i < fields.length() - 1) {
+                format.prevLFList = fields.at(++i);
+            } else if (fields.at(i) == "-c" && i < fields.length() - 1) {
+                format.currentFormatLFList = fields.at(++i);
+            } else {
+                std::cout << "Invalid batch line: " << line.toStdString() << '\n';
+                return false;
+            }
+        }
+
+        formats->append(format);
+    }
+
+    return true;
+}
+
 void printHelp() {
     std::cout << R"(
 REQUIRED arguments:
@@ -61,12 +190,67 @@ REQUIRED arguments:
                   NOTE: If a file already exists in the specified location, it
                   will be overwritten.
 
+  [-p] and [-o] may be omitted when a batch file is given with [-b], or when
+  serving queries with [--serve].
+
 OPTIONAL arguments:
   -l <file>     Specify a previous EDOPro lflist (.conf file) to reference in
-                  order to carry over card limitations.
+                  order to carry over card limitations. The changes from the
+                  previous lflist are also written as a JSON report next to the
+                  output file (Ex: 25th.conf -> 25th.diff.json).
   -c <file>     Specify a current format EDOPro lflist (.conf file) to reference
                   in order to retrieve default card limitations for when new
                   cards get added to the cardpool that do not appear in previous
                   lflist (the file specified with [-p]).
+  -b <file>     Specify a batch file to generate several formats from a single
+                  load of the card databases. Each line of the file describes
+                  one format as "<%> <output file> [-l <file>] [-c <file>]",
+                  where [-l] and [-c] default to the files given on the
+                  command line. Lines starting with '#' are ignored.
+  -q <method>   Specify how the word and character counts at the percentile are
+                  found from the sorted counts of all effect cards: "round"
+                  (default) takes the count at the rounded position, "nearest"
+                  uses the nearest-rank definition and "linear" interpolates
+                  between the two counts around the percentile.
+  -a            Read all card databases through a single SQLite connection,
+                  filtering out tokens and pre-errata cards within the query
+                  so that their text is never loaded.
+  -s <file>     Specify a file to cache card statistics in between runs. Only
+                  cards that are new or whose text has changed since the
+                  previous run have their statistics calculated. The file is
+                  created if it does not exist.
+  --snapshot <file>
+                Specify a file to keep a binary snapshot of the merged card
+                  table in between runs. As long as no card database in the
+                  [-d] directory was added, removed or modified since, the
+                  cards are loaded from the snapshot instead of the databases.
+                  Otherwise the databases are read and the snapshot is written
+                  again. Cannot be combined with [-w].
+  --export-effects <file>
+                Write the simplified effect of every effect card, the text its
+                  word and character counts are taken from, along with the
+                  counts to a JSON file. [-p] and [-o] may be omitted. Cannot
+                  be combined with [-w].
+  -w            Keep running after the lflists are generated, and generate them
+                  again whenever a card database in the [-d] directory or an
+                  lflist given with [-l] or [-c] changes. Only the databases
+                  that changed are read again, and only cards whose text
+                  changed have their statistics calculated again. Cannot be
+                  combined with [-a], [--snapshot] or [--export-effects].
+  --serve <name>
+                Keep the cardpool loaded and answer queries about it on the
+                  local socket with the given name, one JSON request per line
+                  (Ex: {"id": 1, "query": "cards", "cards": ["Scapeghost"]}).
+                  The "cards" query returns the word and character counts and
+                  limits of cards, and the "pool" query the cards within a
+                  "percentile". Implies [-w], and [-p] and [-o] may be omitted.
+                  Limits are taken from the lflists given with [-l] and [-c].
+  --profile <format>
+                Print the time spent in each stage of the run, along with
+                  counts of database rows read, cards filtered, regex passes
+                  and bytes written, to stderr once all formats are generated.
+                  The format is either "table" or "json". Builds configured
+                  with YGOPFG_ALLOC_TRACKING also report the heap allocations
+                  made in each stage.
 )" << std::endl;
 }
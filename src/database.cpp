@@ -1,15 +1,23 @@
 #include "database.h"
+#include "profiler.h"
 
 #include <sqlite3.h>
 #include <iostream>
+#include <algorithm>
 #include <QRegularExpression>
+#include <QUrl>
 
 
-static int selectFromDatasTable(QMap<int, ygo::CardInfo> *data, int argc, char **argv, char **azColName);
-static int selectFromTextsTable(QMap<int, ygo::CardInfo> *data, int argc, char **argv, char **azColName);
-static int selectFromExcludedDatasTable(QMultiMap<int, int> *idsByAlias, int argc, char **argv, char **azColName);
-
-typedef int (*execCallback)(void*, int, char**, char**);
+static bool attachDatabase(sqlite3 *db, const QString &file, int index);
+static bool selectAttachedCardpool(sqlite3 *db, const QString &schema, const std::shared_ptr<ygo::StringArena> &strings,
+                                   QMap<int, ygo::CardInfo> *cardsById);
+static bool selectAttachedExcludedIds(sqlite3 *db, const QString &schema, QMultiMap<int, int> *excludedIdsByAlias);
+template <typename RowFunction>
+static bool forEachRow(sqlite3 *db, const QByteArray &sql, RowFunction onRow);
+static ygo::CardInfo readCardRow(sqlite3_stmt *stmt, const std::shared_ptr<ygo::StringArena> &strings);
+static QString databaseUri(const QString &file);
+static sqlite3 *openDatabase(const QString &file);
+static std::string_view columnUtf8(sqlite3_stmt *stmt, int column);
 
 static const QRegularExpression re_included(R"((^(cards.cdb|cards.delta.cdb)|.*\brelease\b.*\.cdb)$)");
 
@@ -38,172 +46,209 @@ QStringList getExcludedDatabaseFiles(const QFileInfoList &dbFiles) {
     return dbExcludedFiles;
 }
 
-QMap<int, ygo::CardInfo> readCardInfoFromDatabase(const QString &file) {
-    sqlite3 *db = nullptr;
-
-    const int rc = sqlite3_open(file.toStdString().c_str(), &db);
-
-    if (rc) {
-        std::cerr << "Card database could not be opened: " << sqlite3_errmsg(db) << '\n';
-        return {};
+std::optional<QMap<int, ygo::CardInfo>> readCardInfoFromDatabase(const QString &file) {
+    sqlite3 *db = openDatabase(file);
+    if (!db) {
+        return std::nullopt;
     }
 
+    // The text of every card in the database is kept in a single arena, exactly as SQLite stores it
+    const auto strings = std::make_shared<ygo::StringArena>();
     QMap<int, ygo::CardInfo> cards;
+    const bool ok = forEachRow(db, "select datas.id,datas.ot,datas.alias,datas.type,texts.name,texts.desc "
+                                   "from datas join texts on texts.id = datas.id", [&](sqlite3_stmt *stmt) {
+        cards[sqlite3_column_int(stmt, 0)] = readCardRow(stmt, strings);
+    });
 
-    char *errMsg = nullptr;
-    sqlite3_exec(db, "select id,ot,alias,type from datas", (execCallback)selectFromDatasTable, &cards, &errMsg);
+    sqlite3_close(db);
 
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << '\n';
-        sqlite3_free(errMsg);
+    if (!ok) {
+        return std::nullopt;
     }
+    return cards;
+}
 
-    errMsg = nullptr;
-    sqlite3_exec(db, "select id,name,desc from texts", (execCallback)selectFromTextsTable, &cards, &errMsg);
-
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << '\n';
-        sqlite3_free(errMsg);
+std::optional<QMultiMap<int, int>> readExcludedCardIds(const QString &file) {
+    sqlite3 *db = openDatabase(file);
+    if (!db) {
+        return std::nullopt;
     }
 
+    QMultiMap<int, int> idsByAlias;
+    const bool ok = forEachRow(db, "select id,alias from datas where alias != 0", [&](sqlite3_stmt *stmt) {
+        idsByAlias.insert(sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 0));
+    });
+
     sqlite3_close(db);
 
-    return cards;
+    if (!ok) {
+        return std::nullopt;
+    }
+    return idsByAlias;
 }
 
-inline int selectFromDatasTable(QMap<int, ygo::CardInfo> *cards, int argc, char **argv, char **azColName) {
-    ygo::CardInfo card;
-
-    for (int i = 0; i < argc; ++i) {
-        QString colName(azColName[i]);
-        QString value(argv[i] ? argv[i] : "NULL");
+bool readCardpoolFromAttachedDatabases(const QStringList &includedFiles, const QStringList &excludedFiles,
+                                       QMap<int, ygo::CardInfo> *cardsById, QMultiMap<int, int> *excludedIdsByAlias) {
+    sqlite3 *db = nullptr;
+    if (sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI, nullptr) != SQLITE_OK) {
+        std::cerr << "Card database connection could not be opened: " << sqlite3_errmsg(db) << '\n';
+        sqlite3_close(db);
+        return false;
+    }
 
-        if (colName == "id") {
-            bool convertedSuccessfully = false;
-            card.setId(value.toInt(&convertedSuccessfully));
+    // SQLite limits how many databases can be attached to one connection, so the files are attached in batches. The
+    // text of every card is kept in a single arena.
+    const QStringList files = includedFiles + excludedFiles;
+    const auto strings = std::make_shared<ygo::StringArena>();
+    const int batchSize = std::max(1, sqlite3_limit(db, SQLITE_LIMIT_ATTACHED, -1));
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
-        } else if (colName == "ot") {
-            bool convertedSuccessfully = false;
-            card.setOt(value.toInt(&convertedSuccessfully));
+    bool ok = true;
+    for (int first = 0; ok && first < files.count(); first += batchSize) {
+        const int last = std::min(first + batchSize, files.count());
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
-        } else if (colName == "alias") {
-            bool convertedSuccessfully = false;
-            card.setAlias(value.toInt(&convertedSuccessfully));
+        int attached = 0;
+        while (ok && first + attached < last) {
+            ok = attachDatabase(db, files.at(first + attached), attached);
+            attached += ok ? 1 : 0;
+        }
 
-            if (!convertedSuccessfully) {
-                return 1;
+        // The included databases are queried in file order, so later databases still take precedence
+        for (int i = 0; ok && i < attached; ++i) {
+            const auto schema = QString("db%1").arg(i);
+            if (first + i < includedFiles.count()) {
+                ok = selectAttachedCardpool(db, schema, strings, cardsById);
+            } else {
+                ok = selectAttachedExcludedIds(db, schema, excludedIdsByAlias);
             }
-        } else if (colName == "type") {
-            bool convertedSuccessfully = false;
-            card.setCardType(static_cast<ygo::CardType>(value.toInt(&convertedSuccessfully)));
+        }
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
+        for (int i = 0; i < attached; ++i) {
+            sqlite3_exec(db, QString("detach database db%1").arg(i).toUtf8().constData(), nullptr, nullptr, nullptr);
         }
     }
 
-    if (cards->contains(card.id())) {
-        (*cards)[card.id()].setOt(card.ot());
-        (*cards)[card.id()].setAlias(card.alias());
-        (*cards)[card.id()].setCardType(card.cardType());
-    } else {
-        cards->insert(card.id(), card);
-    }
+    sqlite3_close(db);
 
-    return 0;
+    return ok;
 }
 
-inline int selectFromTextsTable(QMap<int, ygo::CardInfo> *cards, int argc, char **argv, char **azColName) {
-    ygo::CardInfo card;
+bool attachDatabase(sqlite3 *db, const QString &file, int index) {
+    const auto sql = QString("attach database ?1 as db%1").arg(index).toUtf8();
+    const auto uri = databaseUri(file).toUtf8();
 
-    for (int i = 0; i < argc; ++i) {
-        QString colName(azColName[i]);
-        QString value(argv[i] ? argv[i] : "NULL");
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.constData(), sql.size(), &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db) << '\n';
+        return false;
+    }
 
-        if (colName == "id") {
-            bool convertedSuccessfully = false;
-            card.setId(value.toInt(&convertedSuccessfully));
+    sqlite3_bind_text(stmt, 1, uri.constData(), uri.size(), SQLITE_TRANSIENT);
+    const int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
-        } else if (colName == "name") {
-            card.setName(value);
-        } else if (colName == "desc") {
-            card.setDescription(value);
-        }
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Card database could not be attached: " << sqlite3_errmsg(db) << '\n';
+        return false;
     }
 
-    if (cards->contains(card.id())) {
-        (*cards)[card.id()].setName(card.name());
-        (*cards)[card.id()].setDescription(card.description());
-    } else {
-        cards->insert(card.id(), card);
-    }
+    return true;
+}
 
-    return 0;
+bool selectAttachedCardpool(sqlite3 *db, const QString &schema, const std::shared_ptr<ygo::StringArena> &strings,
+                            QMap<int, ygo::CardInfo> *cardsById) {
+    // Tokens and pre-errata cards are filtered out by the query, and only cards that are not alt arts have their
+    // description read. Filtered rows are still returned by id, since they override the same card from an earlier
+    // database just as they did before filtering was pushed into SQLite.
+    static const QString legal = "(datas.type & 16384) = 0 and datas.ot != 8";
+    const auto sql = QString("select datas.id,datas.ot,datas.alias,datas.type,"
+                             "case when %2 then texts.name end,"
+                             "case when %2 and datas.alias = 0 then texts.desc end,"
+                             "%2 "
+                             "from %1.datas join %1.texts on texts.id = datas.id").arg(schema, legal).toUtf8();
+
+    qint64 filtered = 0;
+    const bool ok = forEachRow(db, sql, [&](sqlite3_stmt *stmt) {
+        const int id = sqlite3_column_int(stmt, 0);
+        if (sqlite3_column_int(stmt, 6)) {
+            (*cardsById)[id] = readCardRow(stmt, strings);
+        } else {
+            cardsById->remove(id);
+            ++filtered;
+        }
+    });
+    ygo::profiler::count(ygo::ProfileCounter::CardsFiltered, filtered);
+
+    return ok;
 }
 
-QMultiMap<int, int> readExcludedCardIds(const QString &file) {
-    sqlite3 *db = nullptr;
+bool selectAttachedExcludedIds(sqlite3 *db, const QString &schema, QMultiMap<int, int> *excludedIdsByAlias) {
+    const auto sql = QString("select id,alias from %1.datas where alias != 0").arg(schema).toUtf8();
 
-    const int rc = sqlite3_open(file.toStdString().c_str(), &db);
+    return forEachRow(db, sql, [&](sqlite3_stmt *stmt) {
+        excludedIdsByAlias->insert(sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 0));
+    });
+}
 
-    if (rc) {
-        std::cerr << "Card database could not be opened: " << sqlite3_errmsg(db) << '\n';
-        return {};
+template <typename RowFunction>
+bool forEachRow(sqlite3 *db, const QByteArray &sql, RowFunction onRow) {
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.constData(), sql.size(), &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db) << '\n';
+        return false;
     }
 
-    QMultiMap<int, int> idsByAlias;
-
-    char *errMsg = nullptr;
-    sqlite3_exec(db, "select id,alias from datas", (execCallback)selectFromExcludedDatasTable, &idsByAlias, &errMsg);
+    int rc = SQLITE_OK;
+    qint64 rows = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        onRow(stmt);
+        ++rows;
+    }
+    ygo::profiler::count(ygo::ProfileCounter::RowsRead, rows);
 
-    if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << '\n';
-        sqlite3_free(errMsg);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db) << '\n';
     }
 
-    sqlite3_close(db);
+    sqlite3_finalize(stmt);
 
-    return idsByAlias;
+    return rc == SQLITE_DONE;
 }
 
-inline int selectFromExcludedDatasTable(QMultiMap<int, int> *idsByAlias, int argc, char **argv, char **azColName) {
-    int id = 0;
-    int alias = 0;
-
-    for (int i = 0; i < argc; ++i) {
-        QString colName(azColName[i]);
-        QString value(argv[i] ? argv[i] : "NULL");
+ygo::CardInfo readCardRow(sqlite3_stmt *stmt, const std::shared_ptr<ygo::StringArena> &strings) {
+    // The text is appended here, and the card only reads the arena. Only the load appends to it, so the cardpool can
+    // share the text of the cards instead of copying it.
+    const auto name = strings->append(columnUtf8(stmt, 4));
+    const auto description = strings->append(columnUtf8(stmt, 5));
+    ygo::CardInfo card(strings, name, description);
+    card.setId(sqlite3_column_int(stmt, 0));
+    card.setOt(sqlite3_column_int(stmt, 1));
+    card.setAlias(sqlite3_column_int(stmt, 2));
+    card.setCardType(ygo::CardType(static_cast<uint>(sqlite3_column_int64(stmt, 3))));
+    return card;
+}
 
-        if (colName == "id") {
-            bool convertedSuccessfully = false;
-            id = value.toInt(&convertedSuccessfully);
+QString databaseUri(const QString &file) {
+    // The databases are opened read-only. They are not opened as immutable, since watch mode and the query service
+    // read them again while they may be being written, which needs SQLite's locking and journal handling.
+    return QUrl::fromLocalFile(QFileInfo(file).absoluteFilePath()).toString(QUrl::FullyEncoded) + "?mode=ro";
+}
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
-        } else if (colName == "alias") {
-            bool convertedSuccessfully = false;
-            alias = value.toInt(&convertedSuccessfully);
+sqlite3 *openDatabase(const QString &file) {
+    // Each call opens its own connection, so databases can be read from several threads at once
+    sqlite3 *db = nullptr;
+    const int rc = sqlite3_open_v2(databaseUri(file).toUtf8().constData(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI, nullptr);
 
-            if (!convertedSuccessfully) {
-                return 1;
-            }
-        }
+    if (rc) {
+        std::cerr << "Card database could not be opened: " << sqlite3_errmsg(db) << '\n';
+        sqlite3_close(db);
+        return nullptr;
     }
 
-    if (alias != 0) {
-        idsByAlias->insert(alias, id);
-    }
+    return db;
+}
 
-    return 0;
+std::string_view columnUtf8(sqlite3_stmt *stmt, int column) {
+    // sqlite3_column_bytes() must be called after sqlite3_column_text() for the size to match the conversion
+    const auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+    return text ? std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, column))) : std::string_view();
 }
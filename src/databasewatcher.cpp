@@ -0,0 +1,124 @@
+#include "databasewatcher.h"
+
+#include <iostream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+
+
+namespace ygo {
+
+    DatabaseWatcher::DatabaseWatcher(const QString &dbPath, const QString &statisticsCachePath)
+        : m_dbPath(dbPath),
+          m_statisticsCachePath(statisticsCachePath),
+          m_directoryChanged(false),
+          m_databasesChanged(false)
+    {
+        if (!m_statisticsCachePath.isEmpty()) {
+            m_cache.load(m_statisticsCachePath);
+        }
+
+        // Changes are collected until none have happened for a short while, as an update usually touches several files
+        m_debounce.setSingleShot(true);
+        m_debounce.setInterval(100);
+
+        QObject::connect(&m_watcher, &QFileSystemWatcher::fileChanged, [this](const QString &path) {
+            if (m_contents.includedFiles.contains(path) || m_contents.excludedFiles.contains(path)) {
+                m_changedDatabases.append(path);
+                m_databasesChanged = true;
+            }
+            m_debounce.start();
+        });
+        // Only databases being added or removed matter. Anything else written to the directory, such as the lflists
+        // or the statistics cache when they are kept there, would otherwise trigger another build with every write.
+        QObject::connect(&m_watcher, &QFileSystemWatcher::directoryChanged, [this](const QString &) {
+            if (databaseFilesChanged()) {
+                m_directoryChanged = true;
+                m_debounce.start();
+            }
+        });
+        QObject::connect(&m_debounce, &QTimer::timeout, [this] {
+            if (m_directoryChanged) {
+                // Files may have been removed as well as added, so the cardpool is built again either way
+                m_changedDatabases.append(updateDatabaseFiles(m_dbPath, &m_contents));
+                m_directoryChanged = false;
+                m_databasesChanged = true;
+            }
+            update();
+        });
+    }
+
+    void DatabaseWatcher::watchFiles(const QStringList &files) {
+        for (const auto &file : files) {
+            if (!file.isEmpty() && !m_extraFiles.contains(file)) {
+                m_extraFiles.append(file);
+            }
+        }
+    }
+
+    void DatabaseWatcher::start(UpdateFunction onUpdate) {
+        m_onUpdate = std::move(onUpdate);
+        m_changedDatabases = updateDatabaseFiles(m_dbPath, &m_contents);
+        m_databasesChanged = true;
+        update();
+    }
+
+    void DatabaseWatcher::update() {
+        // Nothing needs to be read again when only the extra files changed, but the cardpool is still reported
+        if (m_databasesChanged) {
+            m_changedDatabases.removeDuplicates();
+
+            // Databases that could not be read, such as while they are being written, keep their previous cards and
+            // are read again on the next update
+            m_changedDatabases = readDatabases(m_changedDatabases, &m_contents);
+            for (const auto &file : m_changedDatabases) {
+                std::cout << "Card database could not be read, keeping its previous cards: " << file.toStdString() << '\n';
+            }
+            m_databasesChanged = !m_changedDatabases.isEmpty();
+
+            QMap<int, CardInfo> allCardsById;
+            QMultiMap<int, int> excludedIdsByAlias;
+            mergeDatabases(m_contents, &allCardsById, &excludedIdsByAlias);
+            // Entries of cards that are no longer in the databases are dropped, rather than kept for as long as the
+            // watcher runs
+            m_cache.resetUsage();
+            m_pool = buildCardpool(allCardsById, excludedIdsByAlias, &m_cache);
+            m_cache.dropUnused();
+            if (!m_statisticsCachePath.isEmpty()) {
+                m_cache.save(m_statisticsCachePath);
+            }
+        }
+
+        if (m_onUpdate) {
+            m_onUpdate(m_pool);
+        }
+
+        watchPaths();
+    }
+
+    bool DatabaseWatcher::databaseFilesChanged() const {
+        QSet<QString> files;
+        for (const auto &file : QDir(m_dbPath).entryInfoList({ "*.cdb" }, QDir::Files)) {
+            files.insert(file.filePath());
+        }
+
+        const QStringList knownFiles = m_contents.includedFiles + m_contents.excludedFiles;
+        return files != QSet<QString>(knownFiles.cbegin(), knownFiles.cend());
+    }
+
+    // Files that are replaced rather than written to stop being watched, so this is repeated after every change
+    void DatabaseWatcher::watchPaths() {
+        const QStringList paths = m_contents.includedFiles + m_contents.excludedFiles + m_extraFiles;
+        const QStringList watchedFiles = m_watcher.files();
+        for (const auto &path : paths) {
+            if (!watchedFiles.contains(path) && QFileInfo::exists(path)) {
+                m_watcher.addPath(path);
+            }
+        }
+
+        if (m_watcher.directories().isEmpty()) {
+            m_watcher.addPath(m_dbPath);
+        }
+    }
+
+} // namespace ygo
@@ -0,0 +1,139 @@
+#include "effectsimplifier.h"
+#include "textkernels.h"
+#include "profiler.h"
+
+#include <vector>
+#include <QRegularExpression>
+
+
+namespace ygo {
+
+    // A text removal rule, applied to cards that have any of the types in anyOf (if given) and all of the types in allOf.
+    // A rule with a literal is only matched against text that contains it, since the pattern cannot match otherwise.
+    struct RemovalRule {
+        const char *pattern;
+        const char *literal;
+        CardType anyOf;
+        CardType allOf;
+    };
+
+    // The removal rules, in the order they are applied
+    static const RemovalRule removalRules[] = {
+        // Inclusion/exclusion text.
+        { R"(\(This card('s name)? is (always|not) treated as (an? )?"[^"]+"( card)?\.\))", " treated as ", NullType, NullType },
+
+        // Extra deck materials.
+        { R"(^[^\r\n]+(\r\n|\r|\n))", nullptr, Extra, Monster },
+
+        // Ritual spell card text.
+        { R"(You can Ritual Summon this card with (a(ny)? )?"[^"]+"( Ritual Spell( Card)?| card)?\.)", "You can Ritual Summon this card with ", Ritual, Monster },
+        { R"(This (card|monster) can only be Ritual Summoned with the Ritual Spell Card, "[^"]+"\.)", " can only be Ritual Summoned with the Ritual Spell Card, ", Ritual, Monster },
+
+        // Gemini summoning condition text.
+        { R"(^[^●]+)", nullptr, Gemini, Monster },
+
+        // Statlines of tokens and trap monsters.
+        { R"( \([^\)]+/[^\)]+/Level \d{1,2}/ATK \d+/DEF \d+\))", "/ATK ", NullType, NullType },
+
+        // Type of card "(Monster, Spell, or Trap)".
+        { R"( \(Monster, Spell,( (and/)?or)? Trap\))", " (Monster, Spell,", NullType, NullType },
+
+        // Type of monster card "(Ritual, Fusion, Synchro, Xyz, Pendulum, and Link)".
+        { R"( \((Ritual|Fusion|Synchro|Xyz|Pendulum|Link)(,?( and| or)? (Ritual|Fusion|Synchro|Xyz|Pendulum|Link))+\))", nullptr, NullType, NullType },
+
+        // "(but [its/their] effects can still be activated)".
+        { R"( \(but (its|their) effects can still be activated\))", " effects can still be activated)", NullType, NullType },
+
+        // "(when this card resolves)".
+        { R"( \(when this card resolves\))", " (when this card resolves)", NullType, NullType },
+
+        // "(but [you] can [Normal] Set)".
+        { R"( \(but( you)? can( Normal)? Set\))", " (but", NullType, NullType },
+    };
+
+    // Every rule is compiled once, and still applied on its own so that rules see the text as the rules before them
+    // left it
+    struct RemovalStep {
+        QRegularExpression expression;
+        QString literal;
+        CardType anyOf;
+        CardType allOf;
+
+        bool appliesTo(CardType cardType) const {
+            return (!anyOf || cardType & anyOf) && (cardType & allOf) == allOf;
+        }
+    };
+
+    static std::vector<RemovalStep> compileRemovalRules() {
+        std::vector<RemovalStep> steps;
+        for (const auto &rule : removalRules) {
+            steps.push_back({ QRegularExpression(QString::fromUtf8(rule.pattern)),
+                              rule.literal ? QString::fromUtf8(rule.literal) : QString(), rule.anyOf, rule.allOf });
+        }
+
+        return steps;
+    }
+
+    // Removes every match of re from text. The result is built in scratch, which is then swapped with text, so that
+    // both buffers keep their capacity for the next card.
+    static void removeMatches(const QRegularExpression &re, QString &text, QString &scratch, int &passes) {
+        ++passes;
+        auto it = re.globalMatch(text);
+        if (!it.hasNext()) {
+            return;
+        }
+
+        scratch.resize(0);
+        int last = 0;
+        while (it.hasNext()) {
+            const auto match = it.next();
+            scratch.append(text.constData() + last, match.capturedStart() - last);
+            last = match.capturedEnd();
+        }
+        scratch.append(text.constData() + last, text.size() - last);
+
+        text.swap(scratch);
+    }
+
+    QString simplifyEffect(const QString &description, CardType cardType) {
+        static const std::vector<RemovalStep> removalSteps = compileRemovalRules();
+
+        // Each thread rewrites the text within its own pair of buffers, so the only allocation per card is the result
+        thread_local QString text;
+        thread_local QString scratch;
+        text.resize(0);
+        text.append(description.constData(), description.size());
+
+        // Passes are counted locally and added once, as every thread shares the counter
+        int passes = 0;
+        for (const auto &step : removalSteps) {
+            if (step.appliesTo(cardType) && (step.literal.isEmpty() || text.contains(step.literal))) {
+                removeMatches(step.expression, text, scratch, passes);
+            }
+        }
+
+        // Remove boiler-plate from the effects of pendulums.
+        if (cardType & ygo::Pendulum) {
+            if (cardType & ygo::Normal) {
+                if (!text.contains("[ Pendulum Effect ]")) {
+                    profiler::count(ProfileCounter::RegexPasses, passes);
+                    return QString();
+                }
+                text.remove("[ Pendulum Effect ]");
+                static const QRegularExpression re_flavorText(R"(-{40}.*$)", QRegularExpression::DotMatchesEverythingOption);
+                removeMatches(re_flavorText, text, scratch, passes);
+            } else {
+                static const QString separator = QString('-').repeated(40);
+                text.remove("[ Pendulum Effect ]");
+                text.remove(separator);
+                text.remove("[ Monster Effect ]");
+            }
+        }
+
+        profiler::count(ProfileCounter::RegexPasses, passes);
+
+        // Normalize whitespace
+        return collapseSpacesAndTrim(text);
+    }
+
+} // namespace ygo
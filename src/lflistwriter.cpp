@@ -0,0 +1,155 @@
+#include "lflistwriter.h"
+#include "profiler.h"
+
+#include <cstring>
+
+
+namespace ygo {
+
+    LFListWriter::LFListWriter(QIODevice *device, int bufferSize)
+        : m_device(device),
+          m_buffer(static_cast<size_t>(bufferSize)),
+          m_used(0),
+          m_bytesWritten(0),
+          m_error(false)
+    {
+
+    }
+
+    LFListWriter::~LFListWriter() {
+        flush();
+    }
+
+    void LFListWriter::writeHeader(QStringView formatName) {
+        writeText("#[");
+        appendUtf8(formatName);
+        writeText("]\n!");
+        appendUtf8(formatName);
+        writeText("\n$whitelist\n\n");
+    }
+
+    void LFListWriter::writeCard(int id, int limit, QStringView name) {
+        appendCardPrefix(id, limit);
+        appendUtf8(name);
+        reserve(1);
+        appendChar('\n');
+    }
+
+    void LFListWriter::writeCard(int id, int limit, std::string_view name) {
+        appendCardPrefix(id, limit);
+        reserve(name.size() + 1);
+        std::memcpy(m_buffer.data() + m_used, name.data(), name.size());
+        m_used += name.size();
+        appendChar('\n');
+    }
+
+    void LFListWriter::writeExcludedId(int id) {
+        reserve(16);
+        appendNumber(id);
+        appendChar(' ');
+        appendChar('-');
+        appendChar('1');
+        appendChar('\n');
+    }
+
+    void LFListWriter::writeText(const char *text) {
+        const size_t length = std::strlen(text);
+        reserve(length);
+        std::memcpy(m_buffer.data() + m_used, text, length);
+        m_used += length;
+    }
+
+    bool LFListWriter::flush() {
+        if (m_used > 0) {
+            const qint64 written = m_device->write(m_buffer.data(), static_cast<qint64>(m_used));
+            m_error = m_error || written != static_cast<qint64>(m_used);
+            m_bytesWritten += written > 0 ? written : 0;
+            profiler::count(ProfileCounter::BytesWritten, written > 0 ? written : 0);
+            m_used = 0;
+        }
+
+        return !m_error;
+    }
+
+    // Makes room for size more bytes, flushing the buffer or growing it for anything larger than the whole buffer
+    void LFListWriter::reserve(size_t size) {
+        if (m_buffer.size() - m_used >= size) {
+            return;
+        }
+
+        flush();
+        if (m_buffer.size() < size) {
+            m_buffer.resize(size);
+        }
+    }
+
+    void LFListWriter::appendNumber(int number, int width) {
+        char digits[16];
+        int count = 0;
+
+        const bool negative = number < 0;
+        unsigned value = negative ? 0u - static_cast<unsigned>(number) : static_cast<unsigned>(number);
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        if (negative) {
+            appendChar('-');
+        }
+        for (int i = count; i < width; ++i) {
+            appendChar('0');
+        }
+        while (count > 0) {
+            appendChar(digits[--count]);
+        }
+    }
+
+    // Appends "<id> <limit> --" with the id padded to 8 digits
+    void LFListWriter::appendCardPrefix(int id, int limit) {
+        reserve(32);
+        appendNumber(id, 8);
+        appendChar(' ');
+        appendNumber(limit);
+        appendChar(' ');
+        appendChar('-');
+        appendChar('-');
+    }
+
+    void LFListWriter::appendUtf8(QStringView text) {
+        const auto *data = text.utf16();
+        const qsizetype length = text.size();
+
+        for (qsizetype i = 0; i < length; ++i) {
+            // Flush in between characters, so any amount of text fits through a fixed size buffer
+            reserve(4);
+
+            char32_t c = data[i];
+            if (c >= 0xD800 && c <= 0xDFFF) {
+                // Surrogate pairs are combined, and lone surrogates replaced as QString::toUtf8() does
+                if (c <= 0xDBFF && i + 1 < length && data[i + 1] >= 0xDC00 && data[i + 1] <= 0xDFFF) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (data[++i] - 0xDC00);
+                } else {
+                    c = 0xFFFD;
+                }
+            }
+
+            if (c < 0x80) {
+                appendChar(static_cast<char>(c));
+            } else if (c < 0x800) {
+                appendChar(static_cast<char>(0xC0 | (c >> 6)));
+                appendChar(static_cast<char>(0x80 | (c & 0x3F)));
+            } else if (c < 0x10000) {
+                appendChar(static_cast<char>(0xE0 | (c >> 12)));
+                appendChar(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                appendChar(static_cast<char>(0x80 | (c & 0x3F)));
+            } else {
+                appendChar(static_cast<char>(0xF0 | (c >> 18)));
+                appendChar(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+                appendChar(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+                appendChar(static_cast<char>(0x80 | (c & 0x3F)));
+            }
+        }
+    }
+
+} // namespace ygo
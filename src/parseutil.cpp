@@ -1,8 +1,9 @@
 #include "parseutil.h"
 #include <QFile>
 #include <QTextStream>
-#include <QRegularExpression>
+#include <cstring>
 #include <iostream>
+#include <limits>
 
 
 QString readTextFile(const QString &path) {
@@ -23,35 +24,98 @@ QString readTextFile(const QString &path) {
 }
 
 
-QMap<int, int> parseLFListConf(const QString &path) {
-    auto text = readTextFile(path);
-    if (text.isEmpty()) {
-        return {};
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Parses a single line, accepting "<id> <limit> --<name>" and "<id> -1" entries
+static void parseLFListLine(const char *it, const char *end, LFList *lflist) {
+    while (it != end && isSpace(*it)) {
+        ++it;
+    }
+
+    // Ids too large for an int are read as 0, as QString::toInt() would
+    const char *idStart = it;
+    qint64 id = 0;
+    while (it != end && isDigit(*it)) {
+        id = id <= std::numeric_limits<int>::max() ? id * 10 + (*it - '0') : id;
+        ++it;
+    }
+    if (it == idStart) {
+        return;
+    }
+    if (id > std::numeric_limits<int>::max()) {
+        id = 0;
+    }
+
+    const char *separatorStart = it;
+    while (it != end && isSpace(*it)) {
+        ++it;
+    }
+    if (it == separatorStart || it == end) {
+        return;
+    }
+
+    if (end - it >= 2 && it[0] == '-' && it[1] == '1') {
+        lflist->excludedIds.append(static_cast<int>(id));
+        return;
     }
 
-    static const QRegularExpression re_lineComment(R"(^\s*#.*$)", QRegularExpression::MultilineOption);
-    text.remove(re_lineComment);
+    if (!isDigit(*it)) {
+        return;
+    }
+    const int limit = *it++ - '0';
 
-    static const QRegularExpression re_shebang(R"(^\s*!.*$)", QRegularExpression::MultilineOption);
-    text.remove(re_shebang);
+    separatorStart = it;
+    while (it != end && isSpace(*it)) {
+        ++it;
+    }
+    if (it != separatorStart && end - it >= 2 && it[0] == '-' && it[1] == '-') {
+        lflist->limitsById.insert(static_cast<int>(id), limit);
+    }
+}
 
-    static const QRegularExpression re_whitelist(R"(^\s*\$whitelist\b.*$)", QRegularExpression::MultilineOption);
-    text.remove(re_whitelist);
+LFList parseLFList(const QString &path) {
+    LFList lflist;
+    if (path.isEmpty()) {
+        return lflist;
+    }
 
-    static const QRegularExpression re_blankLines(R"(\n(\s*\n)+)");
-    text.replace(re_blankLines, "\n");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cout << "Could not open file: " << path.toStdString() << '\n';
+        return lflist;
+    }
+
+    // Map the file into memory and parse the lines where they are, falling back to reading it for files that cannot
+    // be mapped
+    QByteArray contents;
+    const char *begin = reinterpret_cast<const char *>(file.size() > 0 ? file.map(0, file.size()) : nullptr);
+    const char *end = begin ? begin + file.size() : nullptr;
+    if (!begin) {
+        contents = file.readAll();
+        begin = contents.constData();
+        end = begin + contents.size();
+    }
+
+    // Skip the UTF-8 byte order mark, which QTextStream used to drop
+    if (end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3;
+    }
 
-    text = text.trimmed() + '\n';
+    for (const char *line = begin; line < end; ) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
 
-    QMap<int, int> cardLimitsById;
-    static const QRegularExpression re_lfEntry(R"(^\s*(?<id>\d+)\s+(?<limit>\d)\s+--.*$)", QRegularExpression::MultilineOption);
-    auto it = re_lfEntry.globalMatch(text);
-    while (it.hasNext()) {
-        const auto entry = it.next();
-        const int id = entry.captured("id").toInt();
-        const int limit = entry.captured("limit").toInt();
-        cardLimitsById.insert(id, limit);
+        parseLFListLine(line, lineEnd, &lflist);
+        line = lineEnd + 1;
     }
 
-    return cardLimitsById;
+    return lflist;
 }
@@ -0,0 +1,388 @@
+#include "pipeline.h"
+#include "cardsnapshot.h"
+#include "cardstatistics.h"
+#include "database.h"
+#include "lflistwriter.h"
+#include "profiler.h"
+
+#include <iostream>
+#include <QDate>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+
+namespace ygo {
+
+    // Calculates the statistics of cards on the worker threads, keeping their simplified effects if given an arena
+    struct StatisticsCalculator {
+        using result_type = CardStatistics;
+
+        CardStatistics operator()(const CardInfo &card) const {
+            return CardStatistics(card, effects);
+        }
+
+        SimplifiedEffectArena *effects;
+    };
+
+    // Returns the rows of the ids that are in the table, skipping the rest
+    static std::vector<int> rowsOf(const CardTable &cards, const QList<int> &ids) {
+        std::vector<int> rows;
+        for (const auto id : ids) {
+            const int row = cards.rowOf(id);
+            if (row >= 0) {
+                rows.push_back(row);
+            }
+        }
+
+        return rows;
+    }
+
+    bool loadCardpool(const QString &dbPath, bool attachDatabases, const QString &snapshotPath, StatisticsCache *cache,
+                      Cardpool *pool) {
+        QMap<int, CardInfo> allCardsById;
+        QMultiMap<int, int> excludedIdsByAlias;
+
+        // The databases are listed before they are read, so a database that changes while being read makes the
+        // snapshot out of date rather than leaving it with the old cards
+        const bool useSnapshot = !snapshotPath.isEmpty();
+        const QList<SnapshotSource> sources = useSnapshot ? snapshotSources(dbPath) : QList<SnapshotSource>();
+        if (useSnapshot) {
+            ScopedStageTimer timer(ProfileStage::DatabaseLoad);
+            if (loadCardSnapshot(snapshotPath, sources, &allCardsById, &excludedIdsByAlias)) {
+                timer.stop();
+                *pool = buildCardpool(allCardsById, excludedIdsByAlias, cache);
+                return true;
+            }
+        }
+
+        if (attachDatabases) {
+            // Tokens and pre-errata cards are already filtered out by the query
+            ScopedStageTimer timer(ProfileStage::DatabaseLoad);
+            const QFileInfoList dbFiles = QDir(dbPath).entryInfoList({ "*.cdb" }, QDir::Files);
+            if (!readCardpoolFromAttachedDatabases(getIncludedDatabaseFiles(dbFiles), getExcludedDatabaseFiles(dbFiles),
+                                                   &allCardsById, &excludedIdsByAlias)) {
+                return false;
+            }
+        } else {
+            DatabaseContents contents;
+            updateDatabaseFiles(dbPath, &contents);
+            if (!readDatabases(contents.includedFiles + contents.excludedFiles, &contents).isEmpty()) {
+                return false;
+            }
+            mergeDatabases(contents, &allCardsById, &excludedIdsByAlias);
+        }
+
+        // Only a complete read of every database is kept as a snapshot
+        if (useSnapshot) {
+            ScopedStageTimer timer(ProfileStage::SnapshotWrite);
+            saveCardSnapshot(snapshotPath, sources, allCardsById, excludedIdsByAlias);
+        }
+
+        *pool = buildCardpool(allCardsById, excludedIdsByAlias, cache);
+        return true;
+    }
+
+    QStringList updateDatabaseFiles(const QString &dbPath, DatabaseContents *contents) {
+        const QFileInfoList dbFiles = QDir(dbPath).entryInfoList({ "*.cdb" }, QDir::Files);
+        const QStringList previousFiles = contents->includedFiles + contents->excludedFiles;
+        contents->includedFiles = getIncludedDatabaseFiles(dbFiles);
+        contents->excludedFiles = getExcludedDatabaseFiles(dbFiles);
+
+        // Drop the contents of files that no longer exist
+        for (const auto &file : previousFiles) {
+            if (!contents->includedFiles.contains(file) && !contents->excludedFiles.contains(file)) {
+                contents->cardsByFile.remove(file);
+                contents->excludedIdsByFile.remove(file);
+            }
+        }
+
+        QStringList newFiles;
+        for (const auto &file : contents->includedFiles + contents->excludedFiles) {
+            if (!previousFiles.contains(file)) {
+                newFiles.append(file);
+            }
+        }
+
+        return newFiles;
+    }
+
+    QStringList readDatabases(const QStringList &files, DatabaseContents *contents) {
+        ScopedStageTimer timer(ProfileStage::DatabaseLoad);
+
+        // Files that are no longer part of the directory are skipped
+        QStringList includedFiles;
+        QStringList excludedFiles;
+        for (const auto &file : files) {
+            if (contents->includedFiles.contains(file)) {
+                includedFiles.append(file);
+            } else if (contents->excludedFiles.contains(file)) {
+                excludedFiles.append(file);
+            }
+        }
+
+        // Read every database concurrently, each on its own thread and connection
+        const auto cardsByDatabase = QtConcurrent::mapped(includedFiles, readCardInfoFromDatabase);
+        const auto idsByAliasByDatabase = QtConcurrent::mapped(excludedFiles, readExcludedCardIds);
+
+        // The results are moved into the contents rather than copied. Files that could not be read keep their
+        // previous contents.
+        QStringList failedFiles;
+        auto cards = cardsByDatabase.results();
+        for (int i = 0; i < cards.count(); ++i) {
+            if (cards[i]) {
+                contents->cardsByFile[includedFiles.at(i)] = std::move(*cards[i]);
+            } else {
+                failedFiles.append(includedFiles.at(i));
+            }
+        }
+
+        auto idsByAlias = idsByAliasByDatabase.results();
+        for (int i = 0; i < idsByAlias.count(); ++i) {
+            if (idsByAlias[i]) {
+                contents->excludedIdsByFile[excludedFiles.at(i)] = std::move(*idsByAlias[i]);
+            } else {
+                failedFiles.append(excludedFiles.at(i));
+            }
+        }
+
+        return failedFiles;
+    }
+
+    void mergeDatabases(const DatabaseContents &contents, QMap<int, CardInfo> *cardsById,
+                        QMultiMap<int, int> *excludedIdsByAlias) {
+        // Consolidate the entire legal cardpool from the databases and map them by id. The databases are merged in
+        // file order, so cards in later databases still take precedence over earlier ones.
+        ScopedStageTimer loadTimer(ProfileStage::DatabaseLoad);
+        for (const auto &file : contents.includedFiles) {
+            cardsById->insert(contents.cardsByFile.value(file));
+        }
+        loadTimer.stop();
+
+        // Collect all card ids that may need to be excluded from the cardpool (rush cards, anime cards, etc.)
+        ScopedStageTimer mergeTimer(ProfileStage::ExclusionMerge);
+        for (const auto &file : contents.excludedFiles) {
+            excludedIdsByAlias->unite(contents.excludedIdsByFile.value(file));
+        }
+    }
+
+    Cardpool buildCardpool(const QMap<int, CardInfo> &allCardsById, const QMultiMap<int, int> &excludedIdsByAlias,
+                           StatisticsCache *cache) {
+        Cardpool pool;
+
+        // Remove tokens and pre-errata cards from the cardpool, and split the effect and non-effect cards by name
+        ScopedStageTimer filterTimer(ProfileStage::Filtering);
+        pool.cards.build(allCardsById);
+
+        // Group every version of each card to handle alt arts and excluded versions
+        pool.groups.build(pool.cards, excludedIdsByAlias);
+        profiler::count(ProfileCounter::CardsFiltered, allCardsById.count() - pool.cards.count());
+        filterTimer.stop();
+
+        // Reuse the statistics of effect cards that have not changed since they were cached. The statistics themselves
+        // are only kept when they refer to simplified effects, which are kept when the cache has an arena for them.
+        ScopedStageTimer statisticsTimer(ProfileStage::Statistics);
+        const bool keepStatistics = cache->simplifiedEffects() != nullptr;
+        std::vector<int> uncachedRows;
+        std::vector<int> uncachedPositions;
+        QList<CardInfo> uncachedCards;
+        for (const int row : pool.cards.effectRows()) {
+            const CardInfo card = pool.cards.card(row);
+            if (const auto stats = cache->lookup(card)) {
+                pool.cards.setCounts(row, stats->wordCount(), stats->charCount());
+                if (keepStatistics) {
+                    pool.effectStatistics.push_back(*stats);
+                }
+            } else {
+                uncachedRows.push_back(row);
+                uncachedCards.append(card);
+                if (keepStatistics) {
+                    uncachedPositions.push_back(static_cast<int>(pool.effectStatistics.size()));
+                    pool.effectStatistics.push_back(CardStatistics(card.id(), 0, 0));
+                }
+            }
+        }
+
+        // Calculate statistics for the remaining effect cards across the thread pool. Cards are handed out to the
+        // worker threads as they become free, and the results are kept in the order of uncachedCards.
+        const auto effectCardStats = QtConcurrent::blockingMapped(uncachedCards, StatisticsCalculator { cache->simplifiedEffects() });
+        for (int i = 0; i < effectCardStats.count(); ++i) {
+            const auto &stats = effectCardStats.at(i);
+            pool.cards.setCounts(uncachedRows[i], stats.wordCount(), stats.charCount());
+            cache->insert(uncachedCards.at(i), stats);
+            if (keepStatistics) {
+                pool.effectStatistics[uncachedPositions[i]] = stats;
+            }
+        }
+        statisticsTimer.stop();
+
+        // Collect the distributions of word and character counts, from which any percentile can be found
+        ScopedStageTimer percentileTimer(ProfileStage::Percentile);
+        for (const int row : pool.cards.effectRows()) {
+            pool.wordCounts.add(pool.cards.wordCount(row));
+            pool.charCounts.add(pool.cards.charCount(row));
+        }
+
+        return pool;
+    }
+
+    Format selectFormat(const Cardpool &pool, double percentile, QuantileMethod method,
+                        LFList previousLFList, LFList currentFormatLFList) {
+        ScopedStageTimer timer(ProfileStage::Percentile);
+        auto limitsByGroup = pool.groups.resolveLimits(previousLFList, currentFormatLFList);
+        timer.stop();
+
+        return selectFormat(pool, percentile, method, std::move(previousLFList), std::move(currentFormatLFList),
+                            std::move(limitsByGroup));
+    }
+
+    Format selectFormat(const Cardpool &pool, double percentile, QuantileMethod method,
+                        LFList previousLFList, LFList currentFormatLFList, std::vector<int> limitsByGroup) {
+        ScopedStageTimer timer(ProfileStage::Percentile);
+
+        Format format;
+        format.name = formatName(percentile);
+        format.previousLFList = std::move(previousLFList);
+        format.currentFormatLFList = std::move(currentFormatLFList);
+
+        // Find the specified percentile for both the word and character counts
+        format.wordPercentile = pool.wordCounts.percentile(percentile, method);
+        format.charPercentile = pool.charCounts.percentile(percentile, method);
+
+        // Collect the effect cards that exist in the percentile, which are already sorted by name
+        const CardTable &cards = pool.cards;
+        std::vector<int> effectRows;
+        for (const int row : cards.effectRows()) {
+            if (cards.wordCount(row) <= format.wordPercentile && cards.charCount(row) <= format.charPercentile) {
+                effectRows.push_back(row);
+            }
+        }
+        format.effectCardCount = static_cast<int>(effectRows.size());
+
+        // Merge in every non-effect card, which takes the place of an effect card of the same name
+        const auto &nonEffectRows = cards.nonEffectRows();
+        format.rows.reserve(effectRows.size() + nonEffectRows.size());
+        auto effect = effectRows.cbegin();
+        auto nonEffect = nonEffectRows.cbegin();
+        while (effect != effectRows.cend() || nonEffect != nonEffectRows.cend()) {
+            if (nonEffect == nonEffectRows.cend() || (effect != effectRows.cend() && cards.name(*effect) < cards.name(*nonEffect))) {
+                format.rows.push_back(*effect++);
+            } else {
+                if (effect != effectRows.cend() && cards.name(*effect) == cards.name(*nonEffect)) {
+                    ++effect;
+                }
+                format.rows.push_back(*nonEffect++);
+            }
+        }
+
+        // Collect the limit of every card and all ids of excluded versions of cards, through the group of each card
+        format.limitsByGroup = std::move(limitsByGroup);
+        format.limitsById.reserve(static_cast<int>(format.rows.size()));
+        for (const int row : format.rows) {
+            const int group = pool.groups.groupOfRow(row);
+            format.limitsById.insert(cards.id(row), format.limitsByGroup[group]);
+
+            for (const auto id : pool.groups.excludedIds(group)) {
+                format.excludedIds.append(id);
+            }
+        }
+
+        return format;
+    }
+
+    int cardLimit(const Cardpool &pool, const QString &name, const LFList &previousLFList,
+                  const LFList &currentFormatLFList) {
+        const int group = pool.groups.groupOf(name);
+        return group < 0 ? 3 : pool.groups.resolveLimit(group, previousLFList, currentFormatLFList);
+    }
+
+    CardpoolDiff diffFormat(const Format &format) {
+        ScopedStageTimer timer(ProfileStage::Diff);
+        return diffCardpool(format.limitsById, format.excludedIds,
+                            format.previousLFList.limitsById, format.previousLFList.excludedIds);
+    }
+
+    bool writeFormat(QIODevice *device, const Format &format, const Cardpool &pool, const CardpoolDiff *diff) {
+        ScopedStageTimer timer(ProfileStage::Output);
+
+        // Write the cardpool
+        const CardTable &cards = pool.cards;
+        LFListWriter out(device);
+        out.writeHeader(format.name);
+        for (const int row : format.rows) {
+            out.writeCard(cards.id(row), format.limitsByGroup[pool.groups.groupOfRow(row)], cards.name(row));
+        }
+
+        // Write the excluded ids
+        if (format.excludedIds.count()) {
+            out.writeText("\n");
+        }
+        for (const auto id : format.excludedIds) {
+            out.writeExcludedId(id);
+        }
+
+        if (!diff || !diff->hasCardChanges()) {
+            return out.flush();
+        }
+
+        // List the cards added and removed since the previous lflist, by name
+        out.writeText("\n## Cards added\n");
+        for (const int row : cards.sortedByName(rowsOf(cards, diff->addedIds))) {
+            out.writeText("# ");
+            out.writeCard(cards.id(row), format.limitsByGroup[pool.groups.groupOfRow(row)], cards.name(row));
+        }
+
+        out.writeText("\n## Cards removed\n");
+        for (const int row : cards.sortedByName(rowsOf(cards, diff->removedIds))) {
+            out.writeText("# ");
+            out.writeCard(cards.id(row), format.limitsByGroup[pool.groups.groupOfRow(row)], cards.name(row));
+        }
+
+        return out.flush();
+    }
+
+    bool writeSimplifiedEffects(const QString &path, const Cardpool &pool, const SimplifiedEffectArena &effects) {
+        ScopedStageTimer timer(ProfileStage::Output);
+
+        const auto &effectRows = pool.cards.effectRows();
+        QJsonArray cards;
+        for (size_t i = 0; i < pool.effectStatistics.size() && i < effectRows.size(); ++i) {
+            const auto &stats = pool.effectStatistics[i];
+            cards.append(QJsonObject {
+                { "id", stats.cardId() },
+                { "name", toQString(pool.cards.name(effectRows[i])) },
+                { "wordCount", stats.wordCount() },
+                { "charCount", stats.charCount() },
+                { "simplifiedEffect", stats.simplifiedEffect(effects) }
+            });
+        }
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cout << "Could not open the simplified effects file: " << path.toStdString() << '\n';
+            return false;
+        }
+
+        profiler::count(ProfileCounter::BytesWritten, file.write(QJsonDocument(cards).toJson()));
+        return file.commit();
+    }
+
+    QString formatName(double percentile) {
+        auto name = QString::number(percentile);
+        if (name.endsWith("1")) {
+            name += "st";
+        } else if (name.endsWith("2")) {
+            name += "nd";
+        } else if (name.endsWith("3")) {
+            name += "rd";
+        } else {
+            name += "th";
+        }
+
+        return QString("%1.%2 %3").arg(QDate::currentDate().year()).arg(QDate::currentDate().month()).arg(name);
+    }
+
+} // namespace ygo
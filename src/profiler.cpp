@@ -0,0 +1,239 @@
+#include "profiler.h"
+
+#include <cstdlib>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+
+namespace ygo {
+
+    namespace profiler {
+
+        std::atomic<bool> enabledFlag(false);
+
+        static const int StageCount = static_cast<int>(ProfileStage::Count);
+        static const int CounterCount = static_cast<int>(ProfileCounter::Count);
+
+        // The allocation hooks are linked into the executable rather than the library, so whether allocations are
+        // tracked is only known once the hooks have been called. They only know the size of freed blocks on glibc,
+        // which the heap peaks depend on.
+        static std::atomic<bool> allocationsRecorded(false);
+        static std::atomic<bool> deallocationsRecorded(false);
+
+        static std::atomic<qint64> stageNanoseconds[StageCount];
+        static std::atomic<qint64> stageCalls[StageCount];
+        static std::atomic<qint64> stagePeakResidentKilobytes[StageCount];
+        static std::atomic<qint64> counters[CounterCount];
+
+        // Allocations made outside of any timed stage are tagged to the extra last entry
+        static std::atomic<int> currentStage(StageCount);
+        static std::atomic<qint64> stageAllocations[StageCount + 1];
+        static std::atomic<qint64> stageAllocatedBytes[StageCount + 1];
+        static std::atomic<qint64> stagePeakHeapBytes[StageCount + 1];
+        static std::atomic<qint64> liveHeapBytes;
+
+        static const char *stageNames[StageCount + 1] = {
+            "databaseLoad", "exclusionMerge", "snapshotWrite", "filtering", "statistics", "lflistParse", "percentile",
+            "output", "diff", "other"
+        };
+        static const char *stageLabels[StageCount + 1] = {
+            "Database load", "Exclusion merge", "Snapshot write", "Filtering", "Statistics", "LFList parse", "Percentile",
+            "Output", "Diff", "Other"
+        };
+        static const char *counterNames[CounterCount] = {
+            "rowsRead", "cardsFiltered", "regexPasses", "bytesWritten"
+        };
+        static const char *counterLabels[CounterCount] = {
+            "Rows read", "Cards filtered", "Regex passes", "Bytes written"
+        };
+
+        static void storeMax(std::atomic<qint64> &maximum, qint64 value) {
+            qint64 current = maximum.load(std::memory_order_relaxed);
+            while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        // Returns the peak resident memory of the process so far, or 0 where it is not available
+        static qint64 peakResidentKilobytes() {
+#ifdef Q_OS_UNIX
+            rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MACOS
+                return usage.ru_maxrss / 1024;
+#else
+                return usage.ru_maxrss;
+#endif
+            }
+#endif
+            return 0;
+        }
+
+        void enable() {
+            enabledFlag.store(true, std::memory_order_relaxed);
+        }
+
+        void addTime(ProfileStage stage, std::chrono::steady_clock::duration time) {
+            const int index = static_cast<int>(stage);
+            stageNanoseconds[index].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+                                              std::memory_order_relaxed);
+            stageCalls[index].fetch_add(1, std::memory_order_relaxed);
+            storeMax(stagePeakResidentKilobytes[index], peakResidentKilobytes());
+        }
+
+        void addCount(ProfileCounter counter, qint64 amount) {
+            counters[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        void recordAllocation(std::size_t size) {
+            // Checked before storing, so that threads only ever write to the flag once
+            if (!allocationsRecorded.load(std::memory_order_relaxed)) {
+                allocationsRecorded.store(true, std::memory_order_relaxed);
+            }
+
+            // The live heap is tracked from the start, so blocks allocated before profiling was enabled are freed
+            // from the right total
+            const qint64 live = liveHeapBytes.fetch_add(static_cast<qint64>(size), std::memory_order_relaxed)
+                             + static_cast<qint64>(size);
+            if (!isEnabled()) {
+                return;
+            }
+
+            const int stage = currentStage.load(std::memory_order_relaxed);
+            stageAllocations[stage].fetch_add(1, std::memory_order_relaxed);
+            stageAllocatedBytes[stage].fetch_add(static_cast<qint64>(size), std::memory_order_relaxed);
+            storeMax(stagePeakHeapBytes[stage], live);
+        }
+
+        void recordDeallocation(std::size_t size) {
+            if (!deallocationsRecorded.load(std::memory_order_relaxed)) {
+                deallocationsRecorded.store(true, std::memory_order_relaxed);
+            }
+            liveHeapBytes.fetch_sub(static_cast<qint64>(size), std::memory_order_relaxed);
+        }
+
+        static bool tracksAllocations() {
+            return allocationsRecorded.load(std::memory_order_relaxed);
+        }
+
+        static bool tracksLiveHeap() {
+            return deallocationsRecorded.load(std::memory_order_relaxed);
+        }
+
+        static ProfileStage enterStage(ProfileStage stage) {
+            return ProfileStage(currentStage.exchange(static_cast<int>(stage), std::memory_order_relaxed));
+        }
+
+        static void leaveStage(ProfileStage previousStage) {
+            currentStage.store(static_cast<int>(previousStage), std::memory_order_relaxed);
+        }
+
+        static double stageMilliseconds(int stage) {
+            return stageNanoseconds[stage].load(std::memory_order_relaxed) / 1e6;
+        }
+
+        static qint64 kilobytes(const std::atomic<qint64> &bytes) {
+            return bytes.load(std::memory_order_relaxed) / 1024;
+        }
+
+        QByteArray tableReport() {
+            QString table = QString("%1 %2 %3 %4").arg("Stage", -16).arg("Time (ms)", 12).arg("Calls", 8)
+                                                  .arg("Peak RSS (KiB)", 16);
+            if (tracksAllocations()) {
+                table += QString(" %1 %2").arg("Allocations", 12).arg("Alloc (KiB)", 12);
+            }
+            if (tracksLiveHeap()) {
+                table += QString(" %1").arg("Peak heap (KiB)", 16);
+            }
+            table += '\n';
+
+            double total = 0;
+            for (int i = 0; i <= StageCount; ++i) {
+                if (i == StageCount && !tracksAllocations()) {
+                    break;
+                }
+
+                const bool timed = i < StageCount;
+                total += timed ? stageMilliseconds(i) : 0;
+                table += QString("%1 %2 %3 %4").arg(stageLabels[i], -16)
+                                               .arg(timed ? QString::number(stageMilliseconds(i), 'f', 3) : "", 12)
+                                               .arg(timed ? QString::number(stageCalls[i].load()) : "", 8)
+                                               .arg(timed ? QString::number(stagePeakResidentKilobytes[i].load()) : "", 16);
+                if (tracksAllocations()) {
+                    table += QString(" %1 %2").arg(stageAllocations[i].load(), 12).arg(kilobytes(stageAllocatedBytes[i]), 12);
+                }
+                if (tracksLiveHeap()) {
+                    table += QString(" %1").arg(kilobytes(stagePeakHeapBytes[i]), 16);
+                }
+                table += '\n';
+            }
+            table += QString("%1 %2\n\n").arg("Total", -16).arg(total, 12, 'f', 3);
+
+            table += QString("%1 %2\n").arg("Counter", -16).arg("Value", 12);
+            for (int i = 0; i < CounterCount; ++i) {
+                table += QString("%1 %2\n").arg(counterLabels[i], -16).arg(counters[i].load(std::memory_order_relaxed), 12);
+            }
+
+            return table.toUtf8();
+        }
+
+        QByteArray jsonReport() {
+            QJsonObject stages;
+            for (int i = 0; i <= StageCount; ++i) {
+                QJsonObject stage;
+                if (i < StageCount) {
+                    stage.insert("milliseconds", stageMilliseconds(i));
+                    stage.insert("calls", stageCalls[i].load(std::memory_order_relaxed));
+                    stage.insert("peakResidentKilobytes", stagePeakResidentKilobytes[i].load(std::memory_order_relaxed));
+                } else if (!tracksAllocations()) {
+                    break;
+                }
+                if (tracksAllocations()) {
+                    stage.insert("allocations", stageAllocations[i].load(std::memory_order_relaxed));
+                    stage.insert("allocatedBytes", stageAllocatedBytes[i].load(std::memory_order_relaxed));
+                }
+                if (tracksLiveHeap()) {
+                    stage.insert("peakHeapBytes", stagePeakHeapBytes[i].load(std::memory_order_relaxed));
+                }
+                stages.insert(stageNames[i], stage);
+            }
+
+            QJsonObject counterValues;
+            for (int i = 0; i < CounterCount; ++i) {
+                counterValues.insert(counterNames[i], counters[i].load(std::memory_order_relaxed));
+            }
+
+            return QJsonDocument(QJsonObject { { "stages", stages }, { "counters", counterValues } }).toJson();
+        }
+
+    } // namespace profiler
+
+
+    ScopedStageTimer::ScopedStageTimer(ProfileStage stage)
+        : m_stage(stage),
+          m_previousStage(ProfileStage::Count),
+          m_enabled(profiler::isEnabled())
+    {
+        if (m_enabled) {
+            m_previousStage = profiler::enterStage(stage);
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ScopedStageTimer::~ScopedStageTimer() {
+        stop();
+    }
+
+    void ScopedStageTimer::stop() {
+        if (m_enabled) {
+            profiler::addTime(m_stage, std::chrono::steady_clock::now() - m_start);
+            profiler::leaveStage(m_previousStage);
+            m_enabled = false;
+        }
+    }
+
+} // namespace ygo
@@ -0,0 +1,57 @@
+#include "quantile.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace ygo {
+
+    void CountHistogram::add(int count) {
+        count = std::max(count, 0);
+        if (static_cast<size_t>(count) >= m_frequencies.size()) {
+            m_frequencies.resize(count + 1, 0);
+        }
+        ++m_frequencies[count];
+        ++m_total;
+    }
+
+    int CountHistogram::valueAt(qsizetype index) const {
+        qsizetype cumulative = 0;
+        for (size_t value = 0; value < m_frequencies.size(); ++value) {
+            cumulative += m_frequencies[value];
+            if (cumulative > index) {
+                return static_cast<int>(value);
+            }
+        }
+
+        return static_cast<int>(m_frequencies.size()) - 1;
+    }
+
+    double CountHistogram::percentile(double percentile, QuantileMethod method) const {
+        if (m_total == 0) {
+            return 0;
+        }
+
+        const double fraction = std::clamp(percentile, 0.0, 100.0) / 100;
+        const qsizetype last = m_total - 1;
+
+        switch (method) {
+        case QuantileMethod::Rounded:
+            return valueAt(std::min(static_cast<qsizetype>(std::round(m_total * fraction)), last));
+        case QuantileMethod::NearestRank:
+            return valueAt(std::max(static_cast<qsizetype>(std::ceil(m_total * fraction)) - 1, qsizetype(0)));
+        case QuantileMethod::Linear: {
+            const double position = last * fraction;
+            const auto lower = static_cast<qsizetype>(std::floor(position));
+            const int lowerValue = valueAt(lower);
+            if (lower == last) {
+                return lowerValue;
+            }
+            return lowerValue + (position - lower) * (valueAt(lower + 1) - lowerValue);
+        }
+        }
+
+        return 0;
+    }
+
+} // namespace ygo
@@ -0,0 +1,238 @@
+#include "queryservice.h"
+
+#include <iostream>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QtConcurrent>
+
+
+namespace ygo {
+
+    static bool parsePercentile(const QJsonValue &value, double *percentile) {
+        if (!value.isDouble() || value.toDouble() < 0 || value.toDouble() > 100) {
+            return false;
+        }
+
+        *percentile = value.toDouble();
+        return true;
+    }
+
+    static bool parseQuantileMethod(const QJsonValue &value, QuantileMethod *method) {
+        const auto text = value.toString("round");
+        if (text == "round") {
+            *method = QuantileMethod::Rounded;
+        } else if (text == "nearest") {
+            *method = QuantileMethod::NearestRank;
+        } else if (text == "linear") {
+            *method = QuantileMethod::Linear;
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+
+    static QJsonObject errorObject(const QString &message) {
+        return QJsonObject { { "error", message } };
+    }
+
+    QueryService::QueryService() {
+        QObject::connect(&m_server, &QLocalServer::newConnection, [this] {
+            acceptConnection();
+        });
+    }
+
+    bool QueryService::listen(const QString &name) {
+        // A socket that is left behind by a server that exited without closing it is removed. One that a running
+        // server still accepts connections on is left alone.
+        if (!m_server.listen(name) && m_server.serverError() == QAbstractSocket::AddressInUseError) {
+            QLocalSocket socket;
+            socket.connectToServer(name);
+            if (socket.waitForConnected(1000)) {
+                std::cerr << "Another server is already listening on the local socket " << name.toStdString() << '\n';
+                return false;
+            }
+
+            QLocalServer::removeServer(name);
+            m_server.listen(name);
+        }
+
+        if (!m_server.isListening()) {
+            std::cerr << "Could not listen on the local socket " << name.toStdString() << ": "
+                      << m_server.errorString().toStdString() << '\n';
+            return false;
+        }
+
+        return true;
+    }
+
+    void QueryService::setCardpool(const Cardpool &pool, LFList previousLFList, LFList currentFormatLFList) {
+        // The limits of every card are resolved once, rather than for every request
+        auto limitsByGroup = pool.groups.resolveLimits(previousLFList, currentFormatLFList);
+        m_state = std::make_shared<const State>(State { pool, std::move(previousLFList), std::move(currentFormatLFList),
+                                                        std::move(limitsByGroup) });
+    }
+
+    QByteArray QueryService::answer(const QByteArray &request) const {
+        return answer(m_state, request);
+    }
+
+    void QueryService::acceptConnection() {
+        while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+            QObject::connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, socket] {
+                while (socket->canReadLine()) {
+                    const QByteArray request = socket->readLine().trimmed();
+                    if (request.isEmpty()) {
+                        continue;
+                    }
+
+                    // Each request is answered from the cardpool at the time it arrived. The watcher belongs to the
+                    // socket, so an answer to a client that has gone away is dropped along with it.
+                    const auto state = m_state;
+                    auto *watcher = new QFutureWatcher<QByteArray>(socket);
+                    QObject::connect(watcher, &QFutureWatcherBase::finished, socket, [socket, watcher] {
+                        socket->write(watcher->result() + '\n');
+                        watcher->deleteLater();
+                    });
+                    watcher->setFuture(QtConcurrent::run([state, request] {
+                        return QueryService::answer(state, request);
+                    }));
+                }
+            });
+        }
+    }
+
+    QByteArray QueryService::answer(const std::shared_ptr<const State> &state, const QByteArray &request) {
+        const auto document = QJsonDocument::fromJson(request);
+        if (!document.isObject()) {
+            return QJsonDocument(errorObject("The request is not a JSON object")).toJson(QJsonDocument::Compact);
+        }
+
+        const auto object = document.object();
+        const auto query = object.value("query").toString();
+
+        QJsonObject response;
+        if (!state) {
+            response = errorObject("The cardpool has not been loaded yet");
+        } else if (query == "cards") {
+            response = answerCards(*state, object);
+        } else if (query == "pool") {
+            response = answerPool(*state, object);
+        } else {
+            response = errorObject(QString("Unknown query: %1").arg(query));
+        }
+
+        if (object.contains("id")) {
+            response.insert("id", object.value("id"));
+        }
+
+        return QJsonDocument(response).toJson(QJsonDocument::Compact);
+    }
+
+    QJsonObject QueryService::answerCards(const State &state, const QJsonObject &request) {
+        const auto &pool = state.pool;
+
+        // The percentile is optional, and only needed to tell whether the cards are within it
+        const bool hasPercentile = request.contains("percentile");
+        double percentile = 0;
+        QuantileMethod method = QuantileMethod::Rounded;
+        if (hasPercentile && (!parsePercentile(request.value("percentile"), &percentile)
+                              || !parseQuantileMethod(request.value("method"), &method))) {
+            return errorObject("Invalid percentile or method");
+        }
+
+        QJsonObject response;
+        double wordPercentile = 0;
+        double charPercentile = 0;
+        if (hasPercentile) {
+            wordPercentile = pool.wordCounts.percentile(percentile, method);
+            charPercentile = pool.charCounts.percentile(percentile, method);
+            response.insert("wordPercentile", wordPercentile);
+            response.insert("charPercentile", charPercentile);
+        }
+
+        QJsonArray cards;
+        for (const auto &value : request.value("cards").toArray()) {
+            // Cards are given by id, of any of their versions including excluded ones, or by name
+            const int group = value.isDouble() ? pool.groups.groupOf(value.toInt()) : pool.groups.groupOf(value.toString());
+
+            QJsonObject card { { "card", value } };
+            if (group < 0) {
+                card.insert("found", false);
+                cards.append(card);
+                continue;
+            }
+
+            const auto ids = pool.groups.ids(group);
+            const QString name = toQString(pool.cards.name(pool.cards.rowOf(*ids.begin())));
+            QJsonArray idArray;
+            for (const auto id : ids) {
+                idArray.append(id);
+            }
+
+            card.insert("found", true);
+            card.insert("name", name);
+            card.insert("ids", idArray);
+            card.insert("limit", state.limitsByGroup[group]);
+
+            // Only the base card of a group is part of the formats, so alt arts without one never are
+            const int baseRow = pool.groups.baseId(group) ? pool.cards.rowOf(pool.groups.baseId(group)) : -1;
+            const bool hasEffect = baseRow >= 0 && pool.cards.hasEffect(baseRow);
+            card.insert("effect", hasEffect);
+            if (hasEffect) {
+                card.insert("wordCount", pool.cards.wordCount(baseRow));
+                card.insert("charCount", pool.cards.charCount(baseRow));
+            }
+
+            if (hasPercentile) {
+                const bool inPercentile = hasEffect
+                    ? pool.cards.wordCount(baseRow) <= wordPercentile && pool.cards.charCount(baseRow) <= charPercentile
+                    : baseRow >= 0;
+                card.insert("inPercentile", inPercentile);
+            }
+
+            cards.append(card);
+        }
+
+        response.insert("cards", cards);
+        return response;
+    }
+
+    QJsonObject QueryService::answerPool(const State &state, const QJsonObject &request) {
+        double percentile = 0;
+        QuantileMethod method = QuantileMethod::Rounded;
+        if (!parsePercentile(request.value("percentile"), &percentile) || !parseQuantileMethod(request.value("method"), &method)) {
+            return errorObject("Invalid percentile or method");
+        }
+
+        // The limits were resolved when the cardpool was set, rather than for every request
+        const Format format = selectFormat(state.pool, percentile, method, state.previousLFList, state.currentFormatLFList,
+                                           state.limitsByGroup);
+
+        QJsonArray cards;
+        for (const int row : format.rows) {
+            cards.append(QJsonObject {
+                { "id", state.pool.cards.id(row) },
+                { "name", toQString(state.pool.cards.name(row)) },
+                { "limit", format.limitsByGroup[state.pool.groups.groupOfRow(row)] }
+            });
+        }
+
+        QJsonArray excludedIds;
+        for (const auto id : format.excludedIds) {
+            excludedIds.append(id);
+        }
+
+        return QJsonObject {
+            { "name", format.name },
+            { "wordPercentile", format.wordPercentile },
+            { "charPercentile", format.charPercentile },
+            { "cards", cards },
+            { "excludedIds", excludedIds }
+        };
+    }
+
+} // namespace ygo
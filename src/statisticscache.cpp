@@ -0,0 +1,143 @@
+#include "statisticscache.h"
+
+#include <iostream>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+
+namespace ygo {
+
+    static const quint32 cacheMagic = 0x59475343; // "YGSC"
+    static const quint32 cacheFormatVersion = 2;
+
+    StatisticsCache::StatisticsCache(SimplifiedEffectArena *effects)
+        : m_effects(effects)
+    {
+
+    }
+
+    bool StatisticsCache::load(const QString &path) {
+        m_entries.clear();
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_5_12);
+
+        quint32 magic = 0;
+        quint32 formatVersion = 0;
+        qint32 count = 0;
+        in >> magic >> formatVersion >> count;
+        if (magic != cacheMagic || formatVersion != cacheFormatVersion || count < 0) {
+            return false;
+        }
+
+        m_entries.reserve(count);
+        for (qint32 i = 0; i < count; ++i) {
+            qint32 id = 0;
+            Entry entry;
+            in >> id >> entry.hash >> entry.wordCount >> entry.charCount >> entry.simplifiedEffect;
+
+            // Simplified effects are only held on to when they are being kept
+            if (!m_effects) {
+                entry.simplifiedEffect = QString();
+            }
+            m_entries[id] = std::move(entry);
+        }
+
+        if (in.status() != QDataStream::Ok) {
+            std::cout << "Statistics cache is corrupt and will be rebuilt: " << path.toStdString() << '\n';
+            m_entries.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool StatisticsCache::save(const QString &path) const {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cout << "Could not open the statistics cache for writing: " << path.toStdString() << '\n';
+            return false;
+        }
+
+        qint32 count = 0;
+        for (const auto &entry : m_entries) {
+            count += entry.used ? 1 : 0;
+        }
+
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_12);
+        out << cacheMagic << cacheFormatVersion << count;
+
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (it->used) {
+                out << qint32(it.key()) << it->hash << it->wordCount << it->charCount
+                    << (m_effects ? it->simplifiedEffect : QString());
+            }
+        }
+
+        return file.commit();
+    }
+
+    std::optional<CardStatistics> StatisticsCache::lookup(const CardInfo &card) {
+        // Entries without a simplified effect are calculated again when simplified effects are kept
+        const auto it = m_entries.find(card.id());
+        if (it == m_entries.end() || it->hash != hashCard(card) || (m_effects && it->simplifiedEffect.isNull())) {
+            return std::nullopt;
+        }
+
+        it->used = true;
+        CardStatistics stats(card.id(), it->wordCount, it->charCount);
+        if (m_effects) {
+            stats.setSimplifiedEffect(m_effects, it->simplifiedEffect);
+        }
+        return stats;
+    }
+
+    void StatisticsCache::insert(const CardInfo &card, const CardStatistics &stats) {
+        Entry entry;
+        entry.hash = hashCard(card);
+        entry.wordCount = stats.wordCount();
+        entry.charCount = stats.charCount();
+        entry.used = true;
+        if (m_effects && stats.hasSimplifiedEffect()) {
+            entry.simplifiedEffect = stats.simplifiedEffect(*m_effects);
+        }
+        m_entries[card.id()] = std::move(entry);
+    }
+
+    void StatisticsCache::resetUsage() {
+        for (auto &entry : m_entries) {
+            entry.used = false;
+        }
+    }
+
+    void StatisticsCache::dropUnused() {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->used) {
+                ++it;
+            } else {
+                it = m_entries.erase(it);
+            }
+        }
+    }
+
+    QByteArray StatisticsCache::hashCard(const CardInfo &card) {
+        const quint32 cardType = card.cardType();
+        const qint32 rulesVersion = CardStatistics::RulesVersion;
+        const auto description = card.descriptionUtf8();
+
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(reinterpret_cast<const char *>(&rulesVersion), sizeof(rulesVersion));
+        hash.addData(reinterpret_cast<const char *>(&cardType), sizeof(cardType));
+        hash.addData(description.data(), static_cast<int>(description.size()));
+        return hash.result();
+    }
+
+} // namespace ygo
@@ -0,0 +1,21 @@
+#include "stringarena.h"
+
+
+namespace ygo {
+
+    StringRef StringArena::append(std::string_view text) {
+        const StringRef ref { static_cast<quint32>(m_data.size()), static_cast<quint32>(text.size()) };
+        m_data.append(text);
+        return ref;
+    }
+
+    StringRef StringArena::append(QStringView text) {
+        const QByteArray utf8 = text.toUtf8();
+        return append(std::string_view(utf8.constData(), static_cast<size_t>(utf8.size())));
+    }
+
+    QString StringArena::text(StringRef ref) const {
+        return toQString(view(ref));
+    }
+
+} // namespace ygo
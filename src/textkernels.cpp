@@ -0,0 +1,197 @@
+#include "textkernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define YGO_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+
+namespace ygo {
+
+    namespace kernels {
+
+        static inline bool isLineBreakOrLowSurrogate(char16_t c) {
+            return c == u'\r' || c == u'\n' || (c & 0xFC00) == 0xDC00;
+        }
+
+        static qsizetype countLineBreaksAndLowSurrogatesScalar(const char16_t *data, qsizetype length) {
+            qsizetype count = 0;
+            for (qsizetype i = 0; i < length; ++i) {
+                count += isLineBreakOrLowSurrogate(data[i]) ? 1 : 0;
+            }
+            return count;
+        }
+
+        // Copies data[from, length) to out, where previousSpace tells whether data[from - 1] was a space
+        static qsizetype collapseSpacesScalar(const char16_t *data, qsizetype from, qsizetype length,
+                                              char16_t *out, qsizetype written, bool previousSpace) {
+            for (qsizetype i = from; i < length; ++i) {
+                const bool space = data[i] == u' ';
+                if (!(space && previousSpace)) {
+                    out[written++] = data[i];
+                }
+                previousSpace = space;
+            }
+            return written;
+        }
+
+#ifdef YGO_X86_KERNELS
+
+        __attribute__((target("sse2")))
+        static qsizetype countLineBreaksAndLowSurrogatesSse2(const char16_t *data, qsizetype length) {
+            const __m128i cr = _mm_set1_epi16('\r');
+            const __m128i lf = _mm_set1_epi16('\n');
+            const __m128i surrogateMask = _mm_set1_epi16(static_cast<short>(0xFC00));
+            const __m128i lowSurrogate = _mm_set1_epi16(static_cast<short>(0xDC00));
+
+            qsizetype count = 0;
+            qsizetype i = 0;
+            for (; i + 8 <= length; i += 8) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                const __m128i matches = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi16(chars, cr), _mm_cmpeq_epi16(chars, lf)),
+                    _mm_cmpeq_epi16(_mm_and_si128(chars, surrogateMask), lowSurrogate));
+                // Each matching code unit sets two bits of the byte mask
+                count += __builtin_popcount(_mm_movemask_epi8(matches)) / 2;
+            }
+
+            return count + countLineBreaksAndLowSurrogatesScalar(data + i, length - i);
+        }
+
+        __attribute__((target("avx2")))
+        static qsizetype countLineBreaksAndLowSurrogatesAvx2(const char16_t *data, qsizetype length) {
+            const __m256i cr = _mm256_set1_epi16('\r');
+            const __m256i lf = _mm256_set1_epi16('\n');
+            const __m256i surrogateMask = _mm256_set1_epi16(static_cast<short>(0xFC00));
+            const __m256i lowSurrogate = _mm256_set1_epi16(static_cast<short>(0xDC00));
+
+            qsizetype count = 0;
+            qsizetype i = 0;
+            for (; i + 16 <= length; i += 16) {
+                const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                const __m256i matches = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi16(chars, cr), _mm256_cmpeq_epi16(chars, lf)),
+                    _mm256_cmpeq_epi16(_mm256_and_si256(chars, surrogateMask), lowSurrogate));
+                count += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(matches))) / 2;
+            }
+
+            return count + countLineBreaksAndLowSurrogatesScalar(data + i, length - i);
+        }
+
+        // Blocks without a space following another space are copied as a whole, the rest fall back to the scalar loop
+        __attribute__((target("sse2")))
+        static qsizetype collapseSpacesSse2(const char16_t *data, qsizetype length, char16_t *out) {
+            const __m128i spaces = _mm_set1_epi16(' ');
+
+            qsizetype written = 0;
+            bool previousSpace = false;
+            qsizetype i = 0;
+            for (; i + 8 <= length; i += 8) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                const unsigned spaceMask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(chars, spaces)));
+                const unsigned followsSpaceMask = (spaceMask << 2) | (previousSpace ? 0x3u : 0x0u);
+
+                if ((spaceMask & followsSpaceMask) == 0) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written), chars);
+                    written += 8;
+                } else {
+                    written = collapseSpacesScalar(data + i, 0, 8, out + written, 0, previousSpace) + written;
+                }
+                previousSpace = spaceMask & 0x8000u;
+            }
+
+            return collapseSpacesScalar(data, i, length, out, written, previousSpace);
+        }
+
+        __attribute__((target("avx2")))
+        static qsizetype collapseSpacesAvx2(const char16_t *data, qsizetype length, char16_t *out) {
+            const __m256i spaces = _mm256_set1_epi16(' ');
+
+            qsizetype written = 0;
+            bool previousSpace = false;
+            qsizetype i = 0;
+            for (; i + 16 <= length; i += 16) {
+                const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                const unsigned spaceMask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(chars, spaces)));
+                const unsigned followsSpaceMask = (spaceMask << 2) | (previousSpace ? 0x3u : 0x0u);
+
+                if ((spaceMask & followsSpaceMask) == 0) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + written), chars);
+                    written += 16;
+                } else {
+                    written = collapseSpacesScalar(data + i, 0, 16, out + written, 0, previousSpace) + written;
+                }
+                previousSpace = spaceMask & 0x80000000u;
+            }
+
+            return collapseSpacesScalar(data, i, length, out, written, previousSpace);
+        }
+
+#endif // YGO_X86_KERNELS
+
+        using CountFunction = qsizetype (*)(const char16_t *, qsizetype);
+        using CollapseFunction = qsizetype (*)(const char16_t *, qsizetype, char16_t *);
+
+        static qsizetype collapseSpacesPlain(const char16_t *data, qsizetype length, char16_t *out) {
+            return collapseSpacesScalar(data, 0, length, out, 0, false);
+        }
+
+        static CountFunction selectCountFunction() {
+#ifdef YGO_X86_KERNELS
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return countLineBreaksAndLowSurrogatesAvx2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return countLineBreaksAndLowSurrogatesSse2;
+            }
+#endif
+            return countLineBreaksAndLowSurrogatesScalar;
+        }
+
+        static CollapseFunction selectCollapseFunction() {
+#ifdef YGO_X86_KERNELS
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return collapseSpacesAvx2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return collapseSpacesSse2;
+            }
+#endif
+            return collapseSpacesPlain;
+        }
+
+        qsizetype countLineBreaksAndLowSurrogates(const char16_t *data, qsizetype length) {
+            static const CountFunction count = selectCountFunction();
+            return count(data, length);
+        }
+
+        qsizetype collapseSpaces(const char16_t *data, qsizetype length, char16_t *out) {
+            static const CollapseFunction collapse = selectCollapseFunction();
+            return collapse(data, length, out);
+        }
+
+    } // namespace kernels
+
+    qsizetype countNonLineBreakChars(QStringView text) {
+        return text.size() - kernels::countLineBreaksAndLowSurrogates(text.utf16(), text.size());
+    }
+
+    QString collapseSpacesAndTrim(QStringView text) {
+        // Trimming first gives the same result, since collapsing spaces never moves the first or last non-whitespace
+        // character
+        const auto trimmed = text.trimmed();
+        if (trimmed.isEmpty()) {
+            return QString();
+        }
+
+        QString result;
+        result.resize(static_cast<int>(trimmed.size()));
+        const auto length = kernels::collapseSpaces(trimmed.utf16(), trimmed.size(), reinterpret_cast<char16_t *>(result.data()));
+        result.resize(static_cast<int>(length));
+
+        return result;
+    }
+
+} // namespace ygo
@@ -0,0 +1,93 @@
+#include "wordscanner.h"
+
+
+namespace ygo {
+
+    static inline bool isWordChar(QChar c) {
+        const ushort u = c.unicode();
+        return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_';
+    }
+
+    static inline bool isWordCharOrApostrophe(QChar c) {
+        return isWordChar(c) || c == QLatin1Char('\'');
+    }
+
+    WordScanner::WordScanner(QStringView text)
+        : m_text(text),
+          m_position(0),
+          m_wordStart(0),
+          m_wordEnd(0)
+    {
+
+    }
+
+    bool WordScanner::next() {
+        const qsizetype length = m_text.size();
+
+        while (m_position < length) {
+            if (!isWordCharOrApostrophe(m_text[m_position]) || !isBoundary(m_position)) {
+                ++m_position;
+                continue;
+            }
+
+            qsizetype runEnd = 0;
+            qsizetype end = matchRun(m_position, &runEnd);
+            if (end < 0) {
+                // No position within the run is a word boundary, so no word can start within it either
+                m_position = runEnd;
+                continue;
+            }
+
+            // Extend the word over any hyphenated parts, (-[\w']+\b)*
+            while (end < length && m_text[end] == QLatin1Char('-')) {
+                const qsizetype partEnd = matchRun(end + 1, &runEnd);
+                if (partEnd < 0) {
+                    break;
+                }
+                end = partEnd;
+            }
+
+            m_wordStart = m_position;
+            m_wordEnd = end;
+            m_position = end;
+            return true;
+        }
+
+        return false;
+    }
+
+    // \b, where the text is surrounded by non-word characters
+    bool WordScanner::isBoundary(qsizetype position) const {
+        const bool wordBefore = position > 0 && isWordChar(m_text[position - 1]);
+        const bool wordAfter = position < m_text.size() && isWordChar(m_text[position]);
+        return wordBefore != wordAfter;
+    }
+
+    // Matches [\w']+\b at from, returning the end of the longest match or -1 if there is none. The end of the whole
+    // run of [\w'] is returned through runEnd.
+    qsizetype WordScanner::matchRun(qsizetype from, qsizetype *runEnd) const {
+        qsizetype end = from;
+        while (end < m_text.size() && isWordCharOrApostrophe(m_text[end])) {
+            ++end;
+        }
+        *runEnd = end;
+
+        for (; end > from; --end) {
+            if (isBoundary(end)) {
+                return end;
+            }
+        }
+
+        return -1;
+    }
+
+    int countWords(QStringView text) {
+        int count = 0;
+        WordScanner scanner(text);
+        while (scanner.next()) {
+            ++count;
+        }
+        return count;
+    }
+
+} // namespace ygo